@@ -0,0 +1,106 @@
+// Stress benchmark of board generation and reveal at increasing sizes, without the GUI.
+//
+//     MS_Benchmark [max_side] [board_file]
+//
+// Square boards from 1000 cells a side doubling up to max_side (100000 by default), the last row is max_side itself.
+// Each size is played twice from a first sweep in the middle:
+//  - generate: 20% mines, the opening is a handful of cells so the time is the mine placement and counting
+//  - reveal:   0.1% mines, the opening floods almost the whole board so the time is mostly the flood fill
+// Boards above s_MAPPED_CELLS are mapped to board_file (ms_benchmark.board by default), the file is removed after each run.
+// Linear scaling shows as a flat ns/cell column, the peak memory is the one of the process so far.
+#include "MineSweeper.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace minesweeper;
+
+static constexpr size_t s_FIRST_SIDE{ 1000 };
+static constexpr size_t s_MAPPED_CELLS{ size_t(1) << 28 };
+
+static size_t peak_memory_mb()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters{};
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PeakWorkingSetSize >> 20;
+#else
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+	return (size_t)usage.ru_maxrss >> 10;
+#endif
+}
+
+// Plays the first sweep of a side x side board with density mines, returns the seconds from new game to the end of the sweep
+static double run(MineSweeper& game, const size_t side, const double density, const char* board_file, Cell_Count& swept)
+{
+	const size_t cells = side * side;
+	const Cell_Count mines = (Cell_Count)(cells * density);
+	const bool is_mapped = cells > s_MAPPED_CELLS;
+
+	const auto start = std::chrono::steady_clock::now();
+	if (is_mapped)
+		game.new_mapped_game(board_file, side, side, mines);
+	else
+		game.new_game(side, side, mines);
+	game.sweep((Cell_Value)(side / 2), (Cell_Value)(side / 2));
+	const auto end = std::chrono::steady_clock::now();
+
+	swept = (Cell_Count)cells - game.get_remaining_cells();
+	if (is_mapped) {
+		// Any other new_game closes the file
+		game.new_game(Difficulty::Easy);
+		std::remove(board_file);
+	}
+	return std::chrono::duration<double>(end - start).count();
+}
+
+static void report(const char* name, const size_t side, const double seconds, const Cell_Count swept)
+{
+	const double cells = (double)side * side;
+	printf("%-9s %7zu %15.0f %13lld %10.3f %8.2f %8zu\n",
+		name, side, cells, (long long)swept, seconds, seconds * 1e9 / cells, peak_memory_mb());
+	fflush(stdout);
+}
+
+int main(int argc, char** argv)
+{
+	const size_t max_side = argc > 1 ? (size_t)strtoull(argv[1], nullptr, 10) : 100000;
+	const char* board_file = argc > 2 ? argv[2] : "ms_benchmark.board";
+	if (max_side < 10) {
+		fprintf(stderr, "usage: MS_Benchmark [max_side >= 10] [board_file]\n");
+		return 1;
+	}
+
+	MineSweeper game(Difficulty::Easy);
+	printf("%-9s %7s %15s %13s %10s %8s %8s\n", "run", "side", "cells", "swept", "seconds", "ns/cell", "peak MB");
+	try {
+		for (size_t side = s_FIRST_SIDE < max_side ? s_FIRST_SIDE : max_side;; side = side * 2 < max_side ? side * 2 : max_side) {
+			Cell_Count swept{};
+			double seconds = run(game, side, 0.2, board_file, swept);
+			report("generate", side, seconds, swept);
+			seconds = run(game, side, 0.001, board_file, swept);
+			report("reveal", side, seconds, swept);
+			if (side == max_side)
+				break;
+		}
+	}
+	catch (const std::exception& e) {
+		fprintf(stderr, "MS_Benchmark: %s\n", e.what());
+		std::remove(board_file);
+		return 1;
+	}
+	return 0;
+}
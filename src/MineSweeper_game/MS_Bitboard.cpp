@@ -0,0 +1,233 @@
+#include "MS_Bitboard.h"
+#include <string.h>
+#include <array>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define MS_TARGET_AVX2
+#define MS_TARGET_SSE2
+#else
+#define MS_TARGET_AVX2 __attribute__((target("avx2")))
+#define MS_TARGET_SSE2 __attribute__((target("sse2")))
+#endif
+#else
+#define MS_X86 0
+#endif
+
+// Bit-sliced sum of the 8 one-bit neighbor inputs into 4 count planes (b0 is the lowest bit).
+// A count never exceeds 8, so b3 set means the other planes are clear.
+#define MS_BITSLICED_SUM8(T, XOR, AND, OR, ul, u, ur, l, r, dl, d, dr, b0, b1, b2, b3) \
+	const T x_a = XOR(ul, u), s_a = XOR(x_a, ur), c_a = OR(AND(ul, u), AND(ur, x_a));	\
+	const T x_b = XOR(l, r), s_b = XOR(x_b, dl), c_b = OR(AND(l, r), AND(dl, x_b));		\
+	const T s_c = XOR(d, dr), c_c = AND(d, dr);											\
+	const T x_d = XOR(s_a, s_b), c_d = OR(AND(s_a, s_b), AND(s_c, x_d));				\
+	const T x_e = XOR(c_a, c_b), t_e = XOR(x_e, c_c), c_e = OR(AND(c_a, c_b), AND(c_c, x_e)); \
+	const T c_f = AND(t_e, c_d);															\
+	b0 = XOR(x_d, s_c);																	\
+	b1 = XOR(t_e, c_d);																	\
+	b2 = XOR(c_e, c_f);																	\
+	b3 = AND(c_e, c_f);
+
+#define MS_XOR64(a, b) ((a) ^ (b))
+#define MS_AND64(a, b) ((a) & (b))
+#define MS_OR64(a, b) ((a) | (b))
+#define MS_LOAD128(p) _mm_loadu_si128((const __m128i*)(p))
+#define MS_LOAD256(p) _mm256_loadu_si256((const __m256i*)(p))
+
+MineSweeper_NS_Begin
+
+namespace {
+	enum class Simd_level { Scalar, SSE2, AVX2 };
+
+	Simd_level detect_simd_level()
+	{
+#if MS_X86
+#ifdef _MSC_VER
+		int info[4]{};
+		__cpuid(info, 0);
+		const int max_leaf = info[0];
+
+		__cpuid(info, 1);
+		const bool sse2 = info[3] & (1 << 26);
+		const bool avx = info[2] & (1 << 28);
+		const bool os_saves_ymm = (info[2] & (1 << 27)) && ((_xgetbv(0) & 6) == 6);
+
+		if (max_leaf >= 7 && avx && os_saves_ymm) {
+			__cpuidex(info, 7, 0);
+			if (info[1] & (1 << 5))
+				return Simd_level::AVX2;
+		}
+		if (sse2)
+			return Simd_level::SSE2;
+#else
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			return Simd_level::AVX2;
+		if (__builtin_cpu_supports("sse2"))
+			return Simd_level::SSE2;
+#endif
+#endif
+		return Simd_level::Scalar;
+	}
+
+	// Word k of the planes gets the counts of columns [64k, 64k + 64) of the middle row
+	void sum_neighbors_scalar(const uint64_t* up, const uint64_t* mid, const uint64_t* down, size_t k, const size_t words, uint64_t* const planes[4])
+	{
+		for (; k < words; k++) {
+			const uint64_t u = up[k], l = mid[k], d = down[k];
+			const uint64_t ul = (u << 1) | (up[k - 1] >> 63), ur = (u >> 1) | (up[k + 1] << 63);
+			const uint64_t r = (l >> 1) | (mid[k + 1] << 63);
+			const uint64_t dl = (d << 1) | (down[k - 1] >> 63), dr = (d >> 1) | (down[k + 1] << 63);
+			const uint64_t left = (l << 1) | (mid[k - 1] >> 63);
+
+			uint64_t b0, b1, b2, b3;
+			MS_BITSLICED_SUM8(uint64_t, MS_XOR64, MS_AND64, MS_OR64, ul, u, ur, left, r, dl, d, dr, b0, b1, b2, b3)
+
+			planes[0][k] = b0;
+			planes[1][k] = b1;
+			planes[2][k] = b2;
+			planes[3][k] = b3;
+		}
+	}
+
+#if MS_X86
+	MS_TARGET_SSE2 void sum_neighbors_sse2(const uint64_t* up, const uint64_t* mid, const uint64_t* down, const size_t words, uint64_t* const planes[4])
+	{
+		size_t k{};
+		for (; k + 2 <= words; k += 2) {
+			const __m128i u = MS_LOAD128(up + k), l = MS_LOAD128(mid + k), d = MS_LOAD128(down + k);
+			const __m128i ul = _mm_or_si128(_mm_slli_epi64(u, 1), _mm_srli_epi64(MS_LOAD128(up + k - 1), 63));
+			const __m128i ur = _mm_or_si128(_mm_srli_epi64(u, 1), _mm_slli_epi64(MS_LOAD128(up + k + 1), 63));
+			const __m128i left = _mm_or_si128(_mm_slli_epi64(l, 1), _mm_srli_epi64(MS_LOAD128(mid + k - 1), 63));
+			const __m128i r = _mm_or_si128(_mm_srli_epi64(l, 1), _mm_slli_epi64(MS_LOAD128(mid + k + 1), 63));
+			const __m128i dl = _mm_or_si128(_mm_slli_epi64(d, 1), _mm_srli_epi64(MS_LOAD128(down + k - 1), 63));
+			const __m128i dr = _mm_or_si128(_mm_srli_epi64(d, 1), _mm_slli_epi64(MS_LOAD128(down + k + 1), 63));
+
+			__m128i b0, b1, b2, b3;
+			MS_BITSLICED_SUM8(__m128i, _mm_xor_si128, _mm_and_si128, _mm_or_si128, ul, u, ur, left, r, dl, d, dr, b0, b1, b2, b3)
+
+			_mm_storeu_si128((__m128i*)(planes[0] + k), b0);
+			_mm_storeu_si128((__m128i*)(planes[1] + k), b1);
+			_mm_storeu_si128((__m128i*)(planes[2] + k), b2);
+			_mm_storeu_si128((__m128i*)(planes[3] + k), b3);
+		}
+
+		sum_neighbors_scalar(up, mid, down, k, words, planes);
+	}
+
+	MS_TARGET_AVX2 void sum_neighbors_avx2(const uint64_t* up, const uint64_t* mid, const uint64_t* down, const size_t words, uint64_t* const planes[4])
+	{
+		size_t k{};
+		for (; k + 4 <= words; k += 4) {
+			const __m256i u = MS_LOAD256(up + k), l = MS_LOAD256(mid + k), d = MS_LOAD256(down + k);
+			const __m256i ul = _mm256_or_si256(_mm256_slli_epi64(u, 1), _mm256_srli_epi64(MS_LOAD256(up + k - 1), 63));
+			const __m256i ur = _mm256_or_si256(_mm256_srli_epi64(u, 1), _mm256_slli_epi64(MS_LOAD256(up + k + 1), 63));
+			const __m256i left = _mm256_or_si256(_mm256_slli_epi64(l, 1), _mm256_srli_epi64(MS_LOAD256(mid + k - 1), 63));
+			const __m256i r = _mm256_or_si256(_mm256_srli_epi64(l, 1), _mm256_slli_epi64(MS_LOAD256(mid + k + 1), 63));
+			const __m256i dl = _mm256_or_si256(_mm256_slli_epi64(d, 1), _mm256_srli_epi64(MS_LOAD256(down + k - 1), 63));
+			const __m256i dr = _mm256_or_si256(_mm256_srli_epi64(d, 1), _mm256_slli_epi64(MS_LOAD256(down + k + 1), 63));
+
+			__m256i b0, b1, b2, b3;
+			MS_BITSLICED_SUM8(__m256i, _mm256_xor_si256, _mm256_and_si256, _mm256_or_si256, ul, u, ur, left, r, dl, d, dr, b0, b1, b2, b3)
+
+			_mm256_storeu_si256((__m256i*)(planes[0] + k), b0);
+			_mm256_storeu_si256((__m256i*)(planes[1] + k), b1);
+			_mm256_storeu_si256((__m256i*)(planes[2] + k), b2);
+			_mm256_storeu_si256((__m256i*)(planes[3] + k), b3);
+		}
+
+		sum_neighbors_scalar(up, mid, down, k, words, planes);
+	}
+#endif
+
+	// Spreads the 8 bits of a byte into the lowest bit of 8 bytes (little endian, byte i = cell i)
+	constexpr std::array<uint64_t, 256> make_spread_table()
+	{
+		std::array<uint64_t, 256> table{};
+		for (size_t b{}; b < 256; b++) {
+			for (size_t i{}; i < 8; i++) {
+				if (b & (size_t(1) << i))
+					table[b] |= uint64_t(1) << (8 * i);
+			}
+		}
+		return table;
+	}
+	constexpr std::array<uint64_t, 256> s_Spread{ make_spread_table() };
+
+	// Copies the count planes of one row into the count bits of its cells, 8 cells per step
+	void scatter_counts(const uint64_t* const planes[4], Cell* row_cells, const Cell_Value width)
+	{
+		constexpr uint64_t count_bits = 0x0F0F0F0F0F0F0F0Full;
+
+		Cell_Value col{};
+		for (; col + 8 <= width; col += 8) {
+			const size_t k = col >> 6;
+			const unsigned shift = col & 63;
+
+			const uint64_t counts = s_Spread[(planes[0][k] >> shift) & 0xFF]
+				| (s_Spread[(planes[1][k] >> shift) & 0xFF] << 1)
+				| (s_Spread[(planes[2][k] >> shift) & 0xFF] << 2)
+				| (s_Spread[(planes[3][k] >> shift) & 0xFF] << 3);
+
+			uint64_t packed;
+			memcpy(&packed, row_cells + col, sizeof(packed));
+			packed = (packed & ~count_bits) | counts;
+			memcpy(row_cells + col, &packed, sizeof(packed));
+		}
+
+		for (; col < width; col++) {
+			const size_t k = col >> 6;
+			const unsigned shift = col & 63;
+
+			uint8_t count{};
+			for (unsigned bit{}; bit < 4; bit++)
+				count |= ((planes[bit][k] >> shift) & 1) << bit;
+
+			row_cells[col].set_adjacent_mines(count);
+		}
+	}
+}
+
+void Mine_bitplane::resize(const Cell_Value rows, const Cell_Value cols)
+{
+	__height = rows;
+	__width = cols;
+	__stride = ((size_t)cols + 63) / 64 + 2;
+	__words.assign(__stride * ((size_t)rows + 2), 0);
+}
+
+void Mine_bitplane::clear()
+{
+	std::fill(__words.begin(), __words.end(), 0);
+}
+
+void count_adjacent_mines(const Mine_bitplane& mines, Cell* cells, std::vector<uint64_t>& plane_buffer)
+{
+	static const Simd_level simd_level = detect_simd_level();
+
+	const size_t words = mines.words_per_row();
+	plane_buffer.resize(4 * words);
+	uint64_t* const planes[4]{ plane_buffer.data(), plane_buffer.data() + words, plane_buffer.data() + 2 * words, plane_buffer.data() + 3 * words };
+
+	for (Cell_Value row{}; row < mines.height(); row++) {
+		const uint64_t* up = mines.row_words(row - 1);
+		const uint64_t* mid = mines.row_words(row);
+		const uint64_t* down = mines.row_words(row + 1);
+
+		switch (simd_level) {
+#if MS_X86
+		case Simd_level::AVX2: sum_neighbors_avx2(up, mid, down, words, planes); break;
+		case Simd_level::SSE2: sum_neighbors_sse2(up, mid, down, words, planes); break;
+#endif
+		default: sum_neighbors_scalar(up, mid, down, 0, words, planes); break;
+		}
+
+		scatter_counts(planes, cells + (size_t)row * mines.width(), mines.width());
+	}
+}
+
+MineSweeper_NS_End
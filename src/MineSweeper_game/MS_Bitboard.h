@@ -0,0 +1,80 @@
+#pragma once
+#include "MS_Cell.h"
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+MineSweeper_NS_Begin
+
+// Index of the lowest set bit of a non-zero word
+inline unsigned lowest_bit_index(const uint64_t word)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return (unsigned)index;
+#elif defined(_MSC_VER)
+	unsigned long index;
+	if (_BitScanForward(&index, (unsigned long)word))
+		return (unsigned)index;
+	_BitScanForward(&index, (unsigned long)(word >> 32));
+	return (unsigned)index + 32;
+#else
+	return (unsigned)__builtin_ctzll(word);
+#endif
+}
+
+// One bit per cell, bit j of word k in a row is column 64 * k + j.
+// Every row is padded by a zero word on both sides and the board by a zero row
+// above and below, so the counting kernel can read neighbors without edge checks.
+class Mine_bitplane
+{
+public:
+	void resize(const Cell_Value rows, const Cell_Value cols);
+	void clear();
+
+	void set(const Cell_Value row, const Cell_Value col) { _word(row, col) |= _bit(col); }
+	void reset(const Cell_Value row, const Cell_Value col) { _word(row, col) &= ~_bit(col); }
+	bool test(const Cell_Value row, const Cell_Value col) const { return __words[_word_index(row, col)] & _bit(col); }
+
+	// First real word of a row, row may be -1 or height() for the padding rows
+	const uint64_t* row_words(const Cell_Value row) const { return &__words[(size_t)(row + 1) * __stride + 1]; }
+
+	// Calls f(row, col) for every set bit in row-major order, a word without mines costs one test
+	template<typename F>
+	void for_each_set(F&& f) const
+	{
+		for (Cell_Value row{}; row < __height; row++) {
+			const uint64_t* words = row_words(row);
+			for (size_t k{}; k < words_per_row(); k++) {
+				for (uint64_t word = words[k]; word; word &= word - 1)
+					f(row, (Cell_Value)(k * 64 + lowest_bit_index(word)));
+			}
+		}
+	}
+
+	size_t words_per_row() const { return __stride - 2; }
+	Cell_Value height() const { return __height; }
+	Cell_Value width() const { return __width; }
+
+private:
+	static uint64_t _bit(const Cell_Value col) { return uint64_t(1) << (col & 63); }
+	size_t _word_index(const Cell_Value row, const Cell_Value col) const { return (size_t)(row + 1) * __stride + 1 + (col >> 6); }
+	uint64_t& _word(const Cell_Value row, const Cell_Value col) { return __words[_word_index(row, col)]; }
+
+private:
+	std::vector<uint64_t> __words;
+	size_t __stride{ 2 };
+	Cell_Value __height{};
+	Cell_Value __width{};
+};
+
+// Writes the number of adjacent mines of every cell of a row-major board into its count bits.
+// Counts are computed for 64 cells at once with a bit-sliced adder over the shifted neighbor rows,
+// using AVX2 or SSE2 when the CPU supports them and plain 64-bit words otherwise.
+// plane_buffer is scratch space, pass the same vector again to avoid reallocating it
+void count_adjacent_mines(const Mine_bitplane& mines, Cell* cells, std::vector<uint64_t>& plane_buffer);
+
+MineSweeper_NS_End
@@ -0,0 +1,276 @@
+#pragma once
+#include "MS_Cell.h"
+#include <vector>
+#include <array>
+#include <algorithm>
+
+MineSweeper_NS_Begin
+
+// Cells of a board, row-major. Boards up to s_INLINE_CELLS cells (every preset) live inside
+// the object and never touch the allocator, bigger ones go to the heap.
+// The cells can also be borrowed from elsewhere, e.g. a mapped file, see attach(...)
+class Board_storage
+{
+public:
+	// Largest preset, Expert 30x20
+	static constexpr size_t s_INLINE_CELLS{ 30 * 20 };
+
+public:
+	Board_storage() : __inline_cells{}, __heap_cells{}, __external_cells{}, __size{}, __is_inline{ true } {}
+
+	// Resizes and resets every cell
+	void assign(const size_t count, const Cell value)
+	{
+		__external_cells = nullptr;
+		__is_inline = count <= s_INLINE_CELLS;
+		if (!__is_inline)
+			__heap_cells.resize(count);
+		__size = count;
+
+		std::fill(begin(), end(), value);
+	}
+
+	// Uses count cells owned by the caller, as they are, until the next assign(...)
+	void attach(Cell* cells, const size_t count)
+	{
+		__external_cells = cells;
+		__size = count;
+	}
+
+	Cell* data() { return __external_cells ? __external_cells : __is_inline ? __inline_cells.data() : __heap_cells.data(); }
+	const Cell* data() const { return __external_cells ? __external_cells : __is_inline ? __inline_cells.data() : __heap_cells.data(); }
+	size_t size() const { return __size; }
+
+	Cell& operator[](const size_t i) { return data()[i]; }
+	const Cell& operator[](const size_t i) const { return data()[i]; }
+
+	Cell* begin() { return data(); }
+	Cell* end() { return data() + __size; }
+	const Cell* begin() const { return data(); }
+	const Cell* end() const { return data() + __size; }
+
+private:
+	std::array<Cell, s_INLINE_CELLS> __inline_cells;
+	std::vector<Cell> __heap_cells;
+	Cell* __external_cells;
+	size_t __size;
+	bool __is_inline;
+};
+
+struct Neighbor_offset
+{
+	Cell_Value row;
+	Cell_Value col;
+};
+
+inline constexpr Neighbor_offset s_NEIGHBOR_OFFSETS[8]{
+	{ -1, -1 }, { -1, 0 }, { -1, 1 },
+	{  0, -1 },            {  0, 1 },
+	{  1, -1 }, {  1, 0 }, {  1, 1 }
+};
+
+// Neighbors of a cell on a row-major board, as row/col offsets for the cells on the edges and as
+// index offsets for the interior ones. Built once per board shape, every neighbor loop of the engine reads it,
+// another topology only needs another table (and its edge rule in for_each_neighbor)
+struct Neighborhood
+{
+	static constexpr size_t s_SIZE{ 8 };
+
+	Neighbor_offset offsets[s_SIZE];
+	ptrdiff_t index_offsets[s_SIZE];
+};
+
+// The 8 surrounding cells on a square grid of the given width
+constexpr Neighborhood make_square_neighborhood(const Cell_Value width)
+{
+	Neighborhood neighborhood{};
+	for (size_t i{}; i < Neighborhood::s_SIZE; i++) {
+		neighborhood.offsets[i] = s_NEIGHBOR_OFFSETS[i];
+		neighborhood.index_offsets[i] = (ptrdiff_t)s_NEIGHBOR_OFFSETS[i].row * width + s_NEIGHBOR_OFFSETS[i].col;
+	}
+	return neighborhood;
+}
+
+// Board shape known at compile time, used by the preset difficulties.
+// Index arithmetic and edge tests against the constants fold away and the neighbor loop unrolls
+template<Cell_Value W, Cell_Value H>
+struct Fixed_board
+{
+	static constexpr Neighborhood s_NEIGHBORHOOD{ make_square_neighborhood(W) };
+
+	static constexpr Cell_Value width() { return W; }
+	static constexpr Cell_Value height() { return H; }
+	static constexpr const Neighborhood& neighborhood() { return s_NEIGHBORHOOD; }
+};
+
+// Board shape only known at runtime, used by custom games. The table is owned by the game
+struct Dynamic_board
+{
+	Cell_Value __width;
+	Cell_Value __height;
+	const Neighborhood* __neighborhood;
+
+	Cell_Value width() const { return __width; }
+	Cell_Value height() const { return __height; }
+	const Neighborhood& neighborhood() const { return *__neighborhood; }
+};
+
+// Calls f(neighbor_index) for every neighbor of index that is inside the board.
+// Interior cells, most of any board, take one range test and then the fixed index offsets,
+// only the cells of the outer ring test every neighbor against the edges
+template<typename Board, typename F>
+inline void for_each_neighbor(const Board& board, const size_t index, F&& f)
+{
+	const Neighborhood& neighborhood = board.neighborhood();
+	const Cell_Value row = (Cell_Value)(index / board.width());
+	const Cell_Value col = (Cell_Value)(index % board.width());
+
+	if ((uint32_t)(row - 1) < (uint32_t)(board.height() - 2) && (uint32_t)(col - 1) < (uint32_t)(board.width() - 2)) {
+		for (const ptrdiff_t offset : neighborhood.index_offsets)
+			f((size_t)((ptrdiff_t)index + offset));
+		return;
+	}
+
+	for (const auto& offset : neighborhood.offsets) {
+		const Cell_Value adj_row = row + offset.row;
+		const Cell_Value adj_col = col + offset.col;
+		if (adj_row < 0 || adj_row >= board.height() || adj_col < 0 || adj_col >= board.width())
+			continue;
+
+		f((size_t)adj_row * board.width() + adj_col);
+	}
+}
+
+// Zero cells waiting to be expanded by sweep_zeros, grouped by bands of s_BAND_ROWS rows.
+// A band is emptied before the next one is taken, the lowest with cells, so the fill works through the board
+// a few rows at a time: the rows it touches stay in cache, and pages of a mapped board are written once instead
+// of on every pass over the board. Only the current band and the rows around it hold cells, not the whole opening
+class Sweep_queue
+{
+public:
+	static constexpr size_t s_BAND_ROWS{ 16 };
+
+	// Empties the queue for a board of the given shape, the buffers keep their capacity
+	void reset(const Cell_Value width, const Cell_Value height)
+	{
+		__band_cells = (size_t)width * s_BAND_ROWS;
+		const size_t bands = ((size_t)height + s_BAND_ROWS - 1) / s_BAND_ROWS;
+		if (__bands.size() < bands)
+			__bands.resize(bands);
+		__stack.clear();
+		__current_band = 0;
+		__lowest_band = SIZE_MAX;
+		__size = 0;
+	}
+
+	void push(const size_t index)
+	{
+		const size_t band = index / __band_cells;
+		if (band == __current_band) {
+			__stack.push_back(index);
+		}
+		else {
+			auto& cells = __bands[band];
+			if (cells.capacity() == 0 && !__spare_buffers.empty()) {
+				cells = std::move(__spare_buffers.back());
+				__spare_buffers.pop_back();
+			}
+			cells.push_back(index);
+			__lowest_band = std::min(__lowest_band, band);
+		}
+		__size++;
+	}
+
+	bool empty() const { return __size == 0; }
+
+	// The last cell pushed to the current band, or to the lowest band with cells once it is empty.
+	// The queue must not be empty
+	size_t pop()
+	{
+		if (__stack.empty())
+			_next_band();
+		const size_t index = __stack.back();
+		__stack.pop_back();
+		__size--;
+		return index;
+	}
+
+private:
+	// Moves the cells of the lowest band to the stack. The band's buffer goes back to the spares for the next band
+	// that gets cells: only the few bands with cells at a time own a buffer, otherwise every band would keep
+	// the capacity of its busiest moment and they would add up to the size of the board.
+	// A sweep like one before reuses the same buffers and doesn't allocate
+	void _next_band()
+	{
+		__current_band = __lowest_band;
+		auto& band = __bands[__current_band];
+		__stack.assign(band.begin(), band.end());
+		band.clear();
+		__spare_buffers.push_back(std::move(band));
+
+		__lowest_band = SIZE_MAX;
+		for (size_t i = __current_band + 1; i < __bands.size(); i++) {
+			if (!__bands[i].empty()) {
+				__lowest_band = i;
+				break;
+			}
+		}
+	}
+
+private:
+	// Cells of the current band
+	std::vector<size_t> __stack;
+	// Cells of the other bands
+	std::vector<std::vector<size_t>> __bands;
+	// Empty buffers of the bands taken so far
+	std::vector<std::vector<size_t>> __spare_buffers;
+	size_t __band_cells{ 1 };
+	size_t __current_band{};
+	// Lowest band with cells besides the current one, SIZE_MAX if there is none
+	size_t __lowest_band{};
+	size_t __size{};
+};
+
+// Iterative flood fill starting from an already sweeped zero cell.
+// Every cell is queued at most once, so the cost is linear in the number of revealed cells.
+// on_reveal(index, cell_before) is called for every revealed cell.
+// Returns the number of cells it revealed
+template<typename Board, typename F>
+Cell_Count sweep_zeros(const Board& board, Cell* cells, Sweep_queue& queue, const size_t start_index, F&& on_reveal)
+{
+	Cell_Count revealed{};
+
+	queue.reset(board.width(), board.height());
+	queue.push(start_index);
+
+	while (!queue.empty()) {
+		const size_t index = queue.pop();
+
+		for_each_neighbor(board, index, [&](const size_t adj_index) {
+			auto& adj_cell = cells[adj_index];
+			if (adj_cell.state() != Cell_State::Unsweeped)
+				return;
+
+			const Cell before = adj_cell;
+			adj_cell.set_state(Cell_State::Sweeped);
+			revealed++;
+			on_reveal(adj_index, before);
+
+			if (adj_cell.adjacent_mines() == 0 && !adj_cell.is_bomb())
+				queue.push(adj_index);
+		});
+	}
+
+	return revealed;
+}
+
+template<typename Board>
+void adjust_adjacent_counts(const Board& board, Cell* cells, const size_t index, const int delta)
+{
+	for_each_neighbor(board, index, [&](const size_t adj_index) {
+		auto& adj_cell = cells[adj_index];
+		adj_cell.set_adjacent_mines((uint8_t)(adj_cell.adjacent_mines() + delta));
+	});
+}
+
+MineSweeper_NS_End
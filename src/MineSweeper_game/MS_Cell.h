@@ -0,0 +1,110 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdexcept>
+
+#define MiSw minesweeper::
+#define MiSw_NS minesweeper
+
+#define MineSweeper_NS_Begin	namespace MiSw_NS {
+#define MineSweeper_NS_End		}
+
+MineSweeper_NS_Begin
+
+typedef typename int Cell_Value;
+// Cell and mine counts, a 100000 x 100000 board has 10^10 cells
+typedef int64_t Cell_Count;
+
+enum class Cell_State
+{
+	Unsweeped,
+	Sweeped,
+	Marked,
+
+	Bomb = '*'
+};
+
+// Packed into a single byte:
+// bits 0-3: number of adjacent mines (0-8)
+// bit  4  : mine
+// bits 5-6: Cell_State (Unsweeped, Sweeped, Marked)
+struct Cell
+{
+	static constexpr uint8_t s_COUNT_MASK{ 0x0F };
+	static constexpr uint8_t s_MINE_BIT{ 0x10 };
+	static constexpr uint8_t s_STATE_SHIFT{ 5 };
+	static constexpr uint8_t s_STATE_MASK{ 0x03 << s_STATE_SHIFT };
+
+	uint8_t bits;
+
+	Cell_State state() const { return Cell_State((bits & s_STATE_MASK) >> s_STATE_SHIFT); }
+	uint8_t adjacent_mines() const { return bits & s_COUNT_MASK; }
+	// Adjacent mines count, or Cell_State::Bomb if the cell is a mine
+	Cell_Value value() const { return is_bomb() ? (Cell_Value)Cell_State::Bomb : adjacent_mines(); }
+
+	bool is_bomb() const { return bits & s_MINE_BIT; }
+	bool is_sweeped() const { return state() == Cell_State::Sweeped; }
+	bool is_marked() const { return state() == Cell_State::Marked; }
+
+	void set_state(const Cell_State state) { bits = (bits & ~s_STATE_MASK) | (((uint8_t)state << s_STATE_SHIFT) & s_STATE_MASK); }
+	void set_adjacent_mines(const uint8_t count) { bits = (bits & ~s_COUNT_MASK) | (count & s_COUNT_MASK); }
+	void set_bomb(const bool bomb) { bits = bomb ? (bits | s_MINE_BIT) : (bits & ~s_MINE_BIT); }
+	void clear() { bits = 0; }
+
+	void reveal() { set_state(Cell_State::Sweeped); }
+};
+static_assert(sizeof(Cell) == 1, "Cell must stay packed into one byte");
+
+// Non-owning view over cells of the grid, a row (stride 1) or a column (stride = width)
+template<typename T>
+class Span
+{
+public:
+	class iterator
+	{
+	public:
+		iterator(T* ptr, ptrdiff_t stride) : __ptr{ ptr }, __stride{ stride } {}
+
+		T& operator*() const { return *__ptr; }
+		T* operator->() const { return __ptr; }
+		iterator& operator++() { __ptr += __stride; return *this; }
+		bool operator==(const iterator& rhs) const { return __ptr == rhs.__ptr; }
+		bool operator!=(const iterator& rhs) const { return __ptr != rhs.__ptr; }
+
+	private:
+		T* __ptr;
+		ptrdiff_t __stride;
+	};
+
+public:
+	Span() : __data{}, __size{}, __stride{ 1 } {}
+	Span(T* data, const size_t size, const ptrdiff_t stride = 1) : __data{ data }, __size{ size }, __stride{ stride } {}
+
+	T& operator[](const size_t i) const { return __data[i * __stride]; }
+	T& at(const size_t i) const { if (i >= __size) throw std::out_of_range("Span::at"); return (*this)[i]; }
+
+	size_t size() const { return __size; }
+	bool empty() const { return __size == 0; }
+	ptrdiff_t stride() const { return __stride; }
+	T* data() const { return __data; }
+
+	iterator begin() const { return iterator(__data, __stride); }
+	iterator end() const { return iterator(__data + __size * __stride, __stride); }
+
+private:
+	T* __data;
+	size_t __size;
+	ptrdiff_t __stride;
+};
+
+struct Pos
+{
+	Cell_Value x;
+	Cell_Value y;
+
+	bool operator==(const Pos& rhs) {
+		return (x == rhs.x && y == rhs.y);
+	}
+};
+
+MineSweeper_NS_End
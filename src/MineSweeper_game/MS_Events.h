@@ -0,0 +1,41 @@
+#pragma once
+#include "MS_Cell.h"
+
+MineSweeper_NS_Begin
+
+enum class Game_event_type : uint8_t
+{
+	Cell_revealed,
+	// A mine was sweeped, the game is over
+	Mine_hit,
+	// A mine shown by reveal_bombs
+	Mine_revealed,
+	Cell_flagged,
+	Cell_unflagged,
+	// A sweeped cell turned back to unsweeped by undo
+	Cell_hidden,
+	// Board editing added or removed a mine at the cell or next to it, its mine bit or count changed
+	Cell_edited,
+	// Restart, new game or any other change of the whole board, cell is the new grid size
+	Board_reset,
+	Game_won
+};
+
+struct Game_event
+{
+	Game_event_type type;
+	Pos cell;
+};
+
+// Event for a single cell whose state changed from before to after
+inline Game_event_type cell_event_type(const Cell before, const Cell after)
+{
+	if (after.is_sweeped() && !before.is_sweeped())
+		return after.is_bomb() ? Game_event_type::Mine_hit : Game_event_type::Cell_revealed;
+	if (before.is_sweeped() && !after.is_sweeped())
+		return Game_event_type::Cell_hidden;
+
+	return after.is_marked() ? Game_event_type::Cell_flagged : Game_event_type::Cell_unflagged;
+}
+
+MineSweeper_NS_End
@@ -0,0 +1,184 @@
+#include "MS_InfiniteBoard.h"
+#include "MS_Random.h"
+#include "MS_Board.h"
+
+MineSweeper_NS_Begin
+
+size_t Infinite_board::Chunk_key_hash::operator()(const Chunk_key& key) const
+{
+	return (size_t)hash64((uint64_t)key.x * 0x9E3779B97F4A7C15ull ^ (uint64_t)key.y);
+}
+
+Infinite_board::Infinite_board(const uint64_t seed, const double density)
+	: __seed{ seed }, __density{ density }, __mine_threshold{}, __chunks{}, __last_key{}, __last_chunk{},
+	__start_pos{}, __is_started{}, __is_game_over{}, __revealed_cells{}, __exploded_mines{}, __flagged_count{}
+{
+	if (!(density >= s_MIN_DENSITY && density <= s_MAX_DENSITY))
+		throw std::invalid_argument("Infinite_board: mine density out of range");
+
+	// 2^64 * density
+	__mine_threshold = (uint64_t)(density * 18446744073709551616.0);
+}
+
+bool Infinite_board::_is_in_start_area(const World_pos& pos) const
+{
+	return __is_started && pos.x >= __start_pos.x - 1 && pos.x <= __start_pos.x + 1 && pos.y >= __start_pos.y - 1 && pos.y <= __start_pos.y + 1;
+}
+
+// Counter based: the cell's hash is keyed on (seed, chunk coordinate, index in chunk) and nothing else
+bool Infinite_board::is_mine(const World_pos& pos) const
+{
+	if (_is_in_start_area(pos))
+		return false;
+
+	const Chunk_key key = _chunk_of(pos);
+	uint64_t h = hash64(__seed ^ 0x6A09E667F3BCC909ull);
+	h = hash64(h ^ (uint64_t)key.x);
+	h = hash64(h ^ (uint64_t)key.y);
+	h = hash64(h ^ (uint64_t)_local_index(pos, key));
+
+	return h < __mine_threshold;
+}
+
+// Fills the mine and count bits of every cell, cell states are kept
+void Infinite_board::_generate_chunk(const Chunk_key& key, Chunk& chunk) const
+{
+	constexpr int64_t window_size = s_CHUNK_SIZE + 2;
+	bool window[window_size * window_size];
+
+	const World_pos origin{ key.x * s_CHUNK_SIZE - 1, key.y * s_CHUNK_SIZE - 1 };
+	for (int64_t row{}; row < window_size; row++) {
+		for (int64_t col{}; col < window_size; col++)
+			window[row * window_size + col] = is_mine({ origin.x + col, origin.y + row });
+	}
+
+	for (int64_t row{}; row < s_CHUNK_SIZE; row++) {
+		for (int64_t col{}; col < s_CHUNK_SIZE; col++) {
+			const bool* up = &window[row * window_size + col];
+			const bool* mid = up + window_size;
+			const bool* down = mid + window_size;
+
+			auto& cell = chunk.cells[row * s_CHUNK_SIZE + col];
+			cell.set_bomb(mid[1]);
+			cell.set_adjacent_mines((uint8_t)(up[0] + up[1] + up[2] + mid[0] + mid[2] + down[0] + down[1] + down[2]));
+		}
+	}
+}
+
+Infinite_board::Chunk& Infinite_board::_chunk(const Chunk_key& key)
+{
+	if (__last_chunk && __last_key == key)
+		return *__last_chunk;
+
+	auto it = __chunks.find(key);
+	if (it == __chunks.end()) {
+		auto chunk = std::make_unique<Chunk>();
+		_generate_chunk(key, *chunk);
+		it = __chunks.emplace(key, std::move(chunk)).first;
+	}
+
+	__last_key = key;
+	__last_chunk = it->second.get();
+	return *__last_chunk;
+}
+
+Cell& Infinite_board::_cell(const World_pos& pos)
+{
+	const Chunk_key key = _chunk_of(pos);
+	return _chunk(key).cells[_local_index(pos, key)];
+}
+
+const Cell& Infinite_board::get_cell(const World_pos& pos)
+{
+	return _cell(pos);
+}
+
+const Cell* Infinite_board::find_cell(const World_pos& pos) const
+{
+	const Chunk_key key = _chunk_of(pos);
+	const auto it = __chunks.find(key);
+	if (it == __chunks.end())
+		return nullptr;
+
+	return &it->second->cells[_local_index(pos, key)];
+}
+
+void Infinite_board::touch_area(const World_pos& min, const World_pos& max)
+{
+	const Chunk_key first = _chunk_of(min);
+	const Chunk_key last = _chunk_of(max);
+
+	for (int64_t y = first.y; y <= last.y; y++) {
+		for (int64_t x = first.x; x <= last.x; x++)
+			_chunk({ x, y });
+	}
+}
+
+bool Infinite_board::sweep(const World_pos& pos)
+{
+	// The first sweep decides the safe area, chunks touched before it must follow it too
+	if (!__is_started) {
+		__start_pos = pos;
+		__is_started = true;
+
+		for (auto& chunk : __chunks)
+			_generate_chunk(chunk.first, *chunk.second);
+	}
+
+	auto& cell = _cell(pos);
+	if (cell.state() != Cell_State::Unsweeped)
+		return true;
+
+	cell.reveal();
+	__revealed_cells++;
+
+	if (cell.is_bomb()) {
+		__exploded_mines++;
+		__is_game_over = true;
+		return false;
+	}
+
+	if (cell.adjacent_mines() != 0)
+		return true;
+
+	// Same iterative flood fill as MineSweeper::_sweep_zeros, chunks are created as the opening reaches them.
+	// References to cells stay valid, chunks never move once created
+	__reveal_stack.clear();
+	__reveal_stack.push_back(pos);
+
+	while (!__reveal_stack.empty()) {
+		const World_pos current = __reveal_stack.back();
+		__reveal_stack.pop_back();
+
+		for (const auto& offset : s_NEIGHBOR_OFFSETS) {
+			const World_pos adj_pos{ current.x + offset.col, current.y + offset.row };
+			auto& adj_cell = _cell(adj_pos);
+			if (adj_cell.state() != Cell_State::Unsweeped)
+				continue;
+
+			adj_cell.reveal();
+			__revealed_cells++;
+
+			if (adj_cell.adjacent_mines() == 0)
+				__reveal_stack.push_back(adj_pos);
+		}
+	}
+
+	return true;
+}
+
+void Infinite_board::toggle_mark(const World_pos& pos)
+{
+	auto& cell = _cell(pos);
+
+	if (cell.state() == Cell_State::Marked) {
+		__flagged_count--;
+		cell.set_state(Cell_State::Unsweeped);
+	}
+	else if (cell.state() == Cell_State::Unsweeped) {
+		__flagged_count++;
+		cell.set_state(Cell_State::Marked);
+	}
+}
+
+MineSweeper_NS_End
@@ -0,0 +1,110 @@
+#pragma once
+#include "MS_Cell.h"
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+MineSweeper_NS_Begin
+
+struct World_pos
+{
+	int64_t x;
+	int64_t y;
+
+	bool operator==(const World_pos& rhs) const { return x == rhs.x && y == rhs.y; }
+};
+
+// Unbounded board made of fixed size chunks that are generated on first touch.
+// Whether a cell holds a mine is a pure function of (seed, chunk coordinate, cell in chunk),
+// so any chunk can be built, and its border counts computed, without generating its neighbors.
+// Memory grows with the explored area only.
+class Infinite_board
+{
+public:
+	static constexpr int64_t s_CHUNK_SIZE{ 32 };
+	static constexpr int64_t s_CHUNK_CELLS{ s_CHUNK_SIZE * s_CHUNK_SIZE };
+	// Below this density the zero cells percolate and a single sweep could open an endless area
+	static constexpr double s_MIN_DENSITY{ 0.15 };
+	static constexpr double s_MAX_DENSITY{ 0.9 };
+
+	struct Chunk
+	{
+		Cell cells[s_CHUNK_CELLS];
+	};
+
+public:
+	// Throws std::invalid_argument if density is out of [s_MIN_DENSITY, s_MAX_DENSITY]
+	Infinite_board(const uint64_t seed, const double density);
+	Infinite_board() = delete;
+
+public:
+	// returns true if successful, false if cell was a mine
+	bool sweep(const World_pos& pos);
+	void toggle_mark(const World_pos& pos);
+
+	// Creates the chunk of the cell if it was never touched
+	const Cell& get_cell(const World_pos& pos);
+	// Never creates chunks, returns nullptr if the chunk was never touched
+	const Cell* find_cell(const World_pos& pos) const;
+	// Creates every chunk overlapping the rectangle, e.g. the visible part of the board
+	void touch_area(const World_pos& min, const World_pos& max);
+
+	uint64_t get_seed() const { return __seed; }
+	double get_density() const { return __density; }
+	size_t get_chunk_count() const { return __chunks.size(); }
+	uint64_t get_revealed_cells() const { return __revealed_cells; }
+	uint64_t get_exploded_mines() const { return __exploded_mines; }
+	uint64_t get_flagged_count() const { return __flagged_count; }
+	bool is_game_over() const { return __is_game_over; }
+	void revive_game() { __is_game_over = false; }
+
+	// Pure function of the seed, usable before the chunk exists
+	bool is_mine(const World_pos& pos) const;
+
+private:
+	struct Chunk_key
+	{
+		int64_t x;
+		int64_t y;
+
+		bool operator==(const Chunk_key& rhs) const { return x == rhs.x && y == rhs.y; }
+	};
+
+	struct Chunk_key_hash
+	{
+		size_t operator()(const Chunk_key& key) const;
+	};
+
+	static int64_t _floor_div(const int64_t a, const int64_t b) { return (a >= 0) ? a / b : -((-a + b - 1) / b); }
+	static Chunk_key _chunk_of(const World_pos& pos) { return { _floor_div(pos.x, s_CHUNK_SIZE), _floor_div(pos.y, s_CHUNK_SIZE) }; }
+	static size_t _local_index(const World_pos& pos, const Chunk_key& key) { return (size_t)((pos.y - key.y * s_CHUNK_SIZE) * s_CHUNK_SIZE + (pos.x - key.x * s_CHUNK_SIZE)); }
+
+	bool _is_in_start_area(const World_pos& pos) const;
+	Chunk& _chunk(const Chunk_key& key);
+	Cell& _cell(const World_pos& pos);
+	void _generate_chunk(const Chunk_key& key, Chunk& chunk) const;
+
+private:
+	uint64_t __seed;
+	double __density;
+	// A cell is a mine if its hash falls below this threshold
+	uint64_t __mine_threshold;
+
+	std::unordered_map<Chunk_key, std::unique_ptr<Chunk>, Chunk_key_hash> __chunks;
+	// Last chunk looked up, consecutive accesses are mostly in the same chunk
+	Chunk_key __last_key;
+	Chunk* __last_chunk;
+
+	World_pos __start_pos;
+	bool __is_started;
+	bool __is_game_over;
+
+	uint64_t __revealed_cells;
+	uint64_t __exploded_mines;
+	uint64_t __flagged_count;
+
+	// Work buffer of the flood fill
+	std::vector<World_pos> __reveal_stack;
+};
+
+MineSweeper_NS_End
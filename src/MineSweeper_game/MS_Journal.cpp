@@ -0,0 +1,102 @@
+#include "MS_Journal.h"
+
+MineSweeper_NS_Begin
+
+void Move_journal::begin_move(const Game_counters& before)
+{
+	__move_before = before;
+	__is_move_open = false;
+}
+
+void Move_journal::_open_move()
+{
+	if (can_redo()) {
+		const Move& first_undone = __moves[__applied_moves];
+		__runs.resize(first_undone.first_run);
+		__before_cells.resize(first_undone.first_cell);
+		__after_cells.resize(first_undone.first_cell);
+		__moves.resize(__applied_moves);
+	}
+
+	__moves.push_back({ __runs.size(), __before_cells.size(), __move_before, __move_before });
+	__is_move_open = true;
+}
+
+void Move_journal::_drop_oldest_moves()
+{
+	// Amortized O(1) per recorded cell, every drop frees at least half of the cap
+	size_t dropped{};
+	while (dropped + 1 < __moves.size() && __before_cells.size() - __moves[dropped].first_cell > s_MAX_CELLS / 2)
+		dropped++;
+	if (dropped == 0)
+		return;
+
+	const size_t first_run = __moves[dropped].first_run;
+	const size_t first_cell = __moves[dropped].first_cell;
+	__moves.erase(__moves.begin(), __moves.begin() + dropped);
+	__runs.erase(__runs.begin(), __runs.begin() + first_run);
+	__before_cells.erase(__before_cells.begin(), __before_cells.begin() + first_cell);
+	__after_cells.erase(__after_cells.begin(), __after_cells.begin() + first_cell);
+	for (auto& move : __moves) {
+		move.first_run -= first_run;
+		move.first_cell -= first_cell;
+	}
+	__applied_moves -= dropped;
+	__is_truncated = true;
+}
+
+void Move_journal::record(const size_t index, const Cell before, const Cell after)
+{
+	if (__is_overflowed)
+		return;
+	if (!__is_move_open)
+		_open_move();
+
+	if (__before_cells.size() - __moves.back().first_cell >= s_MAX_CELLS) {
+		__is_overflowed = true;
+		return;
+	}
+	if (__before_cells.size() >= s_MAX_CELLS)
+		_drop_oldest_moves();
+
+	// Flood fills reveal rows of neighbors in index order, they mostly extend the last run
+	if (__runs.size() > __moves.back().first_run && __runs.back().first_index + __runs.back().length == index)
+		__runs.back().length++;
+	else
+		__runs.push_back({ index, 1 });
+
+	__before_cells.push_back(before);
+	__after_cells.push_back(after);
+}
+
+bool Move_journal::end_move(const Game_counters& after)
+{
+	if (__is_overflowed) {
+		clear();
+		return false;
+	}
+
+	const bool is_complete = !__is_truncated;
+	__is_truncated = false;
+	if (!__is_move_open)
+		return is_complete;
+
+	__moves.back().after = after;
+	__applied_moves = __moves.size();
+	__is_move_open = false;
+	return is_complete;
+}
+
+void Move_journal::clear()
+{
+	__moves.clear();
+	__runs.clear();
+	__before_cells.clear();
+	__after_cells.clear();
+	__applied_moves = 0;
+	__is_move_open = false;
+	__is_overflowed = false;
+	__is_truncated = false;
+}
+
+MineSweeper_NS_End
@@ -0,0 +1,122 @@
+#pragma once
+#include "MS_Cell.h"
+#include <vector>
+
+MineSweeper_NS_Begin
+
+// Game counters saved with every move of the journal
+struct Game_counters
+{
+	Cell_Count remaining_bombs;
+	Cell_Count exploded_bombs;
+	Cell_Count remaining_cells;
+	Cell_Count flagged_count;
+	bool is_game_over;
+};
+
+// Undo/redo history of the moves played on a board.
+// A move is the list of cells it changed, stored as runs of consecutive indices with the cell
+// before and after the move, plus the counters before and after it. Moves only change cell states,
+// undo and redo restore the state alone and leave the mine and count bits as they are now. Undo and redo rewrite
+// those cells only, so their cost is linear in the size of the move, never in the board.
+// Buffers keep their capacity on clear(), a long game stops allocating once they are big enough.
+// The journal holds at most s_MAX_CELLS changed cells, so its memory doesn't grow with the board or the game:
+// the oldest moves are dropped to make room, and a single move bigger than that, e.g. the opening of a huge board,
+// clears the whole history. A move that changes no cell isn't kept and leaves the moves to redo alone
+class Move_journal
+{
+public:
+	static constexpr size_t s_MAX_CELLS{ size_t(1) << 20 };
+
+public:
+	// Starts recording a move, its first changed cell drops the moves that could be redone
+	void begin_move(const Game_counters& before);
+	void record(const size_t index, const Cell before, const Cell after);
+	// Returns false if moves were dropped from the history while recording, the oldest ones,
+	// or all of them if the move itself didn't fit
+	bool end_move(const Game_counters& after);
+
+	// Restore the cells and counters of the last done / undone move, return false if there is none.
+	// on_change(index, before, after) is called for every cell that is rewritten
+	template<typename F>
+	bool undo(Cell* cells, Game_counters& counters, F&& on_change)
+	{
+		if (!can_undo())
+			return false;
+
+		const size_t move = --__applied_moves;
+		_rewrite(move, __after_cells, __before_cells, cells, on_change);
+		counters = __moves[move].before;
+		return true;
+	}
+
+	template<typename F>
+	bool redo(Cell* cells, Game_counters& counters, F&& on_change)
+	{
+		if (!can_redo())
+			return false;
+
+		const size_t move = __applied_moves++;
+		_rewrite(move, __before_cells, __after_cells, cells, on_change);
+		counters = __moves[move].after;
+		return true;
+	}
+
+	bool can_undo() const { return __applied_moves != 0; }
+	bool can_redo() const { return __applied_moves != __moves.size(); }
+	size_t move_count() const { return __moves.size(); }
+	void clear();
+
+private:
+	struct Run
+	{
+		size_t first_index;
+		size_t length;
+	};
+
+	struct Move
+	{
+		size_t first_run;
+		size_t first_cell;
+		Game_counters before;
+		Game_counters after;
+	};
+
+	// Drops the moves that could be redone and starts a move with the counters given to begin_move
+	void _open_move();
+	// Drops the oldest moves until half of s_MAX_CELLS is free, the move being recorded is kept
+	void _drop_oldest_moves();
+
+	size_t _end_run(const size_t move) const { return (move + 1 < __moves.size()) ? __moves[move + 1].first_run : __runs.size(); }
+
+	template<typename F>
+	void _rewrite(const size_t move, const std::vector<Cell>& from, const std::vector<Cell>& to, Cell* cells, F& on_change) const
+	{
+		size_t cell = __moves[move].first_cell;
+		for (size_t run = __moves[move].first_run; run < _end_run(move); run++) {
+			for (size_t i{}; i < __runs[run].length; i++, cell++) {
+				const size_t index = __runs[run].first_index + i;
+				cells[index].set_state(to[cell].state());
+				on_change(index, from[cell], to[cell]);
+			}
+		}
+	}
+
+private:
+	std::vector<Move> __moves;
+	std::vector<Run> __runs;
+	// Cells of the runs before and after their move, in run order
+	std::vector<Cell> __before_cells;
+	std::vector<Cell> __after_cells;
+	// Moves [0, __applied_moves) are on the board, the rest can be redone
+	size_t __applied_moves{};
+	// Counters before the move being recorded, the move is only added with its first cell
+	Game_counters __move_before{};
+	bool __is_move_open{};
+	// The current move changed more cells than the journal can hold
+	bool __is_overflowed{};
+	// Old moves were dropped to make room for the current one
+	bool __is_truncated{};
+};
+
+MineSweeper_NS_End
@@ -0,0 +1,168 @@
+#include "MS_MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MineSweeper_NS_Begin
+
+void Mapped_file::create(const char* path, const size_t size)
+{
+	if (size == 0)
+		throw std::invalid_argument("Mapped_file: can't map an empty file");
+
+	_map(path, true, size);
+}
+
+void Mapped_file::open(const char* path)
+{
+	_map(path, false, 0);
+}
+
+void Mapped_file::swap(Mapped_file& other)
+{
+#ifdef _WIN32
+	std::swap(__file, other.__file);
+	std::swap(__mapping, other.__mapping);
+#else
+	std::swap(__fd, other.__fd);
+#endif
+	std::swap(__data, other.__data);
+	std::swap(__size, other.__size);
+}
+
+#ifdef _WIN32
+
+void Mapped_file::_map(const char* path, const bool create, size_t size)
+{
+	close();
+
+	HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("Mapped_file: can't open the file");
+
+	if (!create) {
+		LARGE_INTEGER file_size{};
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+			CloseHandle(file);
+			throw std::runtime_error("Mapped_file: can't map an empty file");
+		}
+		size = (size_t)file_size.QuadPart;
+	}
+
+	// Creating the mapping with the full size grows the file to it
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, nullptr);
+	if (!mapping) {
+		CloseHandle(file);
+		throw std::runtime_error("Mapped_file: can't map the file");
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (!view) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		throw std::runtime_error("Mapped_file: can't map the file");
+	}
+
+	__file = file;
+	__mapping = mapping;
+	__data = (uint8_t*)view;
+	__size = size;
+}
+
+void Mapped_file::flush()
+{
+	if (!is_open())
+		return;
+
+	FlushViewOfFile(__data, 0);
+	FlushFileBuffers(__file);
+}
+
+void Mapped_file::close()
+{
+	if (__data)
+		UnmapViewOfFile(__data);
+	if (__mapping)
+		CloseHandle(__mapping);
+	if (__file)
+		CloseHandle(__file);
+
+	__file = nullptr;
+	__mapping = nullptr;
+	__data = nullptr;
+	__size = 0;
+}
+
+#else
+
+void Mapped_file::_map(const char* path, const bool create, size_t size)
+{
+	close();
+
+	const int fd = ::open(path, create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+	if (fd < 0)
+		throw std::runtime_error("Mapped_file: can't open the file");
+
+	if (create) {
+		// Sparse on most file systems, untouched pages take no disk space
+		if (ftruncate(fd, (off_t)size) != 0) {
+			::close(fd);
+			throw std::runtime_error("Mapped_file: can't grow the file");
+		}
+	}
+	else {
+		struct stat file_stat {};
+		if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+			::close(fd);
+			throw std::runtime_error("Mapped_file: can't map an empty file");
+		}
+		size = (size_t)file_stat.st_size;
+	}
+
+	void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (view == MAP_FAILED) {
+		::close(fd);
+		throw std::runtime_error("Mapped_file: can't map the file");
+	}
+
+	__fd = fd;
+	__data = (uint8_t*)view;
+	__size = size;
+}
+
+void Mapped_file::flush()
+{
+	if (!is_open())
+		return;
+
+	msync(__data, __size, MS_SYNC);
+}
+
+void Mapped_file::close()
+{
+	if (__data)
+		munmap(__data, __size);
+	if (__fd >= 0)
+		::close(__fd);
+
+	__fd = -1;
+	__data = nullptr;
+	__size = 0;
+}
+
+#endif
+
+MineSweeper_NS_End
@@ -0,0 +1,44 @@
+#pragma once
+#include "MS_Cell.h"
+
+MineSweeper_NS_Begin
+
+// A whole file mapped read-write into memory, pages are loaded and written back by the OS on demand.
+// Throws std::runtime_error when the file can't be created, opened or mapped
+class Mapped_file
+{
+public:
+	Mapped_file() = default;
+	~Mapped_file() { close(); }
+	Mapped_file(const Mapped_file&) = delete;
+	Mapped_file& operator=(const Mapped_file&) = delete;
+
+public:
+	// Creates the file, or truncates an existing one, with size bytes that read as zeros
+	void create(const char* path, const size_t size);
+	// Maps an existing file, its size is whatever it is on disk
+	void open(const char* path);
+	// Writes the dirty pages back to the file, without waiting for the OS to do it
+	void flush();
+	void close();
+	void swap(Mapped_file& other);
+
+	bool is_open() const { return __data != nullptr; }
+	uint8_t* data() const { return __data; }
+	size_t size() const { return __size; }
+
+private:
+	void _map(const char* path, const bool create, size_t size);
+
+private:
+#ifdef _WIN32
+	void* __file{};
+	void* __mapping{};
+#else
+	int __fd{ -1 };
+#endif
+	uint8_t* __data{};
+	size_t __size{};
+};
+
+MineSweeper_NS_End
@@ -0,0 +1,52 @@
+#pragma once
+#include "MS_Cell.h"
+#include <atomic>
+
+MineSweeper_NS_Begin
+
+// Bounded lock-free queue between exactly one producer thread and one consumer thread.
+// Neither side ever blocks, push fails when the queue is full and pop when it is empty. Size must be a power of two
+template<typename T, size_t Size>
+class Spsc_queue
+{
+	static_assert(Size != 0 && (Size & (Size - 1)) == 0, "Spsc_queue: size must be a power of two");
+
+public:
+	Spsc_queue() = default;
+	Spsc_queue(const Spsc_queue&) = delete;
+	Spsc_queue& operator=(const Spsc_queue&) = delete;
+
+	// Producer side
+	bool push(const T& item)
+	{
+		const size_t tail = __tail.load(std::memory_order_relaxed);
+		if (tail - __head.load(std::memory_order_acquire) == Size)
+			return false;
+
+		__items[tail & (Size - 1)] = item;
+		__tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+	bool full() const { return __tail.load(std::memory_order_relaxed) - __head.load(std::memory_order_acquire) == Size; }
+
+	// Consumer side
+	bool pop(T& item)
+	{
+		const size_t head = __head.load(std::memory_order_relaxed);
+		if (head == __tail.load(std::memory_order_acquire))
+			return false;
+
+		item = __items[head & (Size - 1)];
+		__head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+	bool empty() const { return __head.load(std::memory_order_relaxed) == __tail.load(std::memory_order_acquire); }
+
+private:
+	// Each index on its own cache line, the two threads don't invalidate each other's line on every push and pop
+	alignas(64) std::atomic<size_t> __head{};
+	alignas(64) std::atomic<size_t> __tail{};
+	T __items[Size];
+};
+
+MineSweeper_NS_End
@@ -0,0 +1,96 @@
+#pragma once
+#include "MS_Cell.h"
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+MineSweeper_NS_Begin
+
+// SplitMix64 output function, a stateless 64-bit mixer
+inline uint64_t hash64(uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+// SplitMix64, used to expand a single 64-bit seed into generator states
+inline uint64_t splitmix64(uint64_t& state)
+{
+	return hash64(state += 0x9E3779B97F4A7C15ull);
+}
+
+// High 64 bits of a 64 x 64 bit product
+inline uint64_t mul_hi64(const uint64_t a, const uint64_t b)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	return __umulh(a, b);
+#elif defined(__SIZEOF_INT128__)
+	return (uint64_t)(((unsigned __int128)a * b) >> 64);
+#else
+	const uint64_t a_lo = (uint32_t)a, a_hi = a >> 32, b_lo = (uint32_t)b, b_hi = b >> 32;
+	const uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+	const uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+	return hi_hi + (hi_lo >> 32) + (cross >> 32);
+#endif
+}
+
+// xoshiro256** by Blackman and Vigna. Small, fast and good enough for board generation.
+// Satisfies UniformRandomBitGenerator, so it works with <algorithm> and <random> as well.
+// Everything here is specified bit for bit, so the same seed gives the same sequence on every platform.
+class Xoshiro256ss
+{
+public:
+	using result_type = uint64_t;
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return ~result_type(0); }
+
+public:
+	explicit Xoshiro256ss(const uint64_t seed = 0) { this->seed(seed); }
+
+	void seed(uint64_t seed)
+	{
+		for (auto& word : __state)
+			word = splitmix64(seed);
+	}
+
+	result_type operator()()
+	{
+		const uint64_t result = _rotate_left(__state[1] * 5, 7) * 9;
+		const uint64_t t = __state[1] << 17;
+
+		__state[2] ^= __state[0];
+		__state[3] ^= __state[1];
+		__state[1] ^= __state[2];
+		__state[0] ^= __state[3];
+		__state[2] ^= t;
+		__state[3] = _rotate_left(__state[3], 45);
+
+		return result;
+	}
+
+	// Uniform in [0, range), without modulo bias (Lemire's multiply and reject)
+	uint64_t bounded(const uint64_t range)
+	{
+		uint64_t x = (*this)();
+		uint64_t low = x * range;
+		if (low < range) {
+			const uint64_t threshold = (0 - range) % range;
+			while (low < threshold) {
+				x = (*this)();
+				low = x * range;
+			}
+		}
+		return mul_hi64(x, range);
+	}
+
+private:
+	static uint64_t _rotate_left(const uint64_t x, const int k) { return (x << k) | (x >> (64 - k)); }
+
+private:
+	uint64_t __state[4];
+};
+
+MineSweeper_NS_End
@@ -0,0 +1,71 @@
+#include "MS_Snapshot.h"
+#include <algorithm>
+
+MineSweeper_NS_Begin
+
+void Board_snapshot::_update(const MineSweeper& game)
+{
+	__diff = game.get_difficulty();
+	__remaining_bombs = game.get_remaining_bombs();
+	__bombs_count = game.get_mine_count();
+	__exploded_bombs = game.get_exploded_mines();
+	__remaining_cells = game.get_remaining_cells();
+	__is_game_over = game.is_game_over();
+	__is_game_won = game.is_game_won();
+
+	if (game.get_version() == __version)
+		return;
+
+	const Cell_Value tile_rows = game.tile_rows();
+	const Cell_Value tile_cols = game.tile_cols();
+	const bool is_new_grid = game.width() != __width || game.height() != __height || __tile_versions.size() != (size_t)tile_rows * tile_cols;
+	if (is_new_grid) {
+		__width = game.width();
+		__height = game.height();
+		__cells.resize((size_t)__width * __height);
+		__tile_versions.assign((size_t)tile_rows * tile_cols, 0);
+	}
+
+	for (Cell_Value tile_row{}; tile_row < tile_rows; tile_row++) {
+		for (Cell_Value tile_col{}; tile_col < tile_cols; tile_col++) {
+			auto& tile_version = __tile_versions[(size_t)tile_row * tile_cols + tile_col];
+			const uint64_t version = game.get_tile_version(tile_row, tile_col);
+			if (!is_new_grid && version == tile_version)
+				continue;
+
+			_copy_tile(game, tile_row, tile_col);
+			tile_version = version;
+		}
+	}
+
+	__version = game.get_version();
+}
+
+void Board_snapshot::_copy_tile(const MineSweeper& game, const Cell_Value tile_row, const Cell_Value tile_col)
+{
+	const Cell_Value first_row = tile_row * MineSweeper::s_TILE_SIZE;
+	const Cell_Value first_col = tile_col * MineSweeper::s_TILE_SIZE;
+	const Cell_Value last_row = std::min(first_row + MineSweeper::s_TILE_SIZE, __height);
+	const size_t length = (size_t)(std::min(first_col + MineSweeper::s_TILE_SIZE, __width) - first_col);
+
+	for (Cell_Value row = first_row; row < last_row; row++) {
+		const Cell* source = game.get_row<Access::Unchecked>(row).data() + first_col;
+		std::copy(source, source + length, &__cells[(size_t)row * __width + first_col]);
+	}
+}
+
+void Snapshot_buffer::publish(const MineSweeper& game)
+{
+	__slots[__back]._update(game);
+	__back = __middle.exchange(__back | s_FRESH, std::memory_order_acq_rel) & s_INDEX;
+}
+
+const Board_snapshot& Snapshot_buffer::acquire()
+{
+	if (__middle.load(std::memory_order_relaxed) & s_FRESH)
+		__front = __middle.exchange(__front, std::memory_order_acq_rel) & s_INDEX;
+
+	return __slots[__front];
+}
+
+MineSweeper_NS_End
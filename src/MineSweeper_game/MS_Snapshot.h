@@ -0,0 +1,95 @@
+#pragma once
+#include "MineSweeper.h"
+#include <atomic>
+
+MineSweeper_NS_Begin
+
+// Copy of a board and its counters at one version of the game, never changed while a reader holds it
+class Board_snapshot
+{
+public:
+	uint64_t get_version() const { return __version; }
+	Pos get_grid_size() const { return Pos{ __width, __height }; }
+	Cell_Value height() const { return __height; }
+	Cell_Value width() const { return __width; }
+
+	template<Access A = Access::Checked>
+	const Cell& get_cell(const Cell_Value row, const Cell_Value col) const { return __cells[_index<A>(row, col)]; }
+	template<Access A = Access::Checked>
+	Grid_view get_row(const Cell_Value row) const { return Grid_view(&__cells[_index<A>(row, 0)], __width); }
+
+	Difficulty get_difficulty() const { return __diff; }
+	Cell_Count get_remaining_bombs() const { return __remaining_bombs; }
+	Cell_Count get_mine_count() const { return __bombs_count; }
+	Cell_Count get_exploded_mines() const { return __exploded_bombs; }
+	Cell_Count get_remaining_cells() const { return __remaining_cells; }
+	bool is_game_over() const { return __is_game_over; }
+	bool is_game_won() const { return __is_game_won; }
+
+private:
+	friend class Snapshot_buffer;
+
+	// Brings the copy to the version of game, only the tiles whose version changed are copied
+	void _update(const MineSweeper& game);
+	void _copy_tile(const MineSweeper& game, const Cell_Value tile_row, const Cell_Value tile_col);
+
+	template<Access A>
+	size_t _index(const Cell_Value row, const Cell_Value col) const {
+		if constexpr (A == Access::Checked) {
+			if (row < 0 || row >= __height || col < 0 || col >= __width)
+				throw std::out_of_range("Board_snapshot: cell out of the grid");
+		}
+		else {
+			assert(row >= 0 && row < __height && col >= 0 && col < __width && "Board_snapshot: cell out of the grid");
+		}
+		return (size_t)row * __width + col;
+	}
+
+private:
+	uint64_t __version{};
+	Cell_Value __width{};
+	Cell_Value __height{};
+	std::vector<Cell> __cells;
+	// Version of every tile when it was last copied, same layout as the tiles of the game
+	std::vector<uint64_t> __tile_versions;
+
+	Difficulty __diff{ Difficulty::Custom };
+	Cell_Count __remaining_bombs{};
+	Cell_Count __bombs_count{};
+	Cell_Count __exploded_bombs{};
+	Cell_Count __remaining_cells{};
+	bool __is_game_over{};
+	bool __is_game_won{};
+};
+
+// Triple buffer of board snapshots between the one thread that owns the game and one reader thread, e.g. rendering.
+// The owner publishes after its changes, the reader takes the latest published snapshot. Neither side locks or waits,
+// a snapshot the reader holds is never written until it takes a newer one.
+// A publish copies the tiles changed since the snapshot it overwrites was made, not the whole board
+class Snapshot_buffer
+{
+public:
+	Snapshot_buffer() : __middle{ 1 }, __back{ 2 }, __front{ 0 } {}
+	Snapshot_buffer(const Snapshot_buffer&) = delete;
+	Snapshot_buffer& operator=(const Snapshot_buffer&) = delete;
+
+	// Owner side, game must not change during the call. A buffer follows a single game
+	void publish(const MineSweeper& game);
+
+	// Reader side, the latest published snapshot. It stays valid and unchanged until the next acquire()
+	const Board_snapshot& acquire();
+
+private:
+	// __middle holds the index of the middle slot, and s_FRESH if it was published since the reader took one
+	static constexpr uint8_t s_FRESH{ 4 };
+	static constexpr uint8_t s_INDEX{ 3 };
+
+	Board_snapshot __slots[3];
+	std::atomic<uint8_t> __middle;
+	// Only used by the owner
+	uint8_t __back;
+	// Only used by the reader
+	uint8_t __front;
+};
+
+MineSweeper_NS_End
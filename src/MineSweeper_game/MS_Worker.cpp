@@ -0,0 +1,85 @@
+#include "MS_Worker.h"
+#include <chrono>
+
+MineSweeper_NS_Begin
+
+Action_result run_action(MineSweeper& game, const Action& action)
+{
+	Action_result result{ action.Type, action.Cell, Action_outcome::Out_of_grid, {} };
+	if (action.Cell.y < 0 || action.Cell.y >= game.height() || action.Cell.x < 0 || action.Cell.x >= game.width())
+		return result;
+
+	// Chord is the only action whose mine is not the cell it was played on
+	if (action.Type == Action_type::Chord) {
+		const auto chord = game.chord(action.Cell);
+		result.Outcome = chord.ExplodedMines ? Action_outcome::Mine_hit : chord.RevealedCells ? Action_outcome::Changed : Action_outcome::Unchanged;
+		result.ExplodedCell = chord.ExplodedCell;
+		return result;
+	}
+
+	game.apply(Span<const Action>(&action, 1), Span<Action_outcome>(&result.Outcome, 1));
+	result.ExplodedCell = action.Cell;
+	return result;
+}
+
+void Game_worker::start(MineSweeper& game, Snapshot_buffer& snapshots)
+{
+	stop();
+
+	// Readers see the board as it is handed over, not the last board the worker published
+	snapshots.publish(game);
+
+	__game = &game;
+	__snapshots = &snapshots;
+	__is_stopping.store(false, std::memory_order_relaxed);
+	__worker_thread = std::thread(&Game_worker::_run, this);
+}
+
+void Game_worker::stop()
+{
+	if (!is_running())
+		return;
+
+	__is_stopping.store(true, std::memory_order_release);
+	__worker_thread.join();
+	__game = nullptr;
+	__snapshots = nullptr;
+}
+
+void Game_worker::_run()
+{
+	// Spins for a while when idle, a click right after another is picked up at once, then naps to leave the core alone
+	constexpr int spins_before_nap{ 1000 };
+	int idle_spins{};
+
+	Action action{};
+	while (true) {
+		bool has_played = false;
+		while (__actions.pop(action)) {
+			const Action_result result = run_action(*__game, action);
+			has_played = true;
+
+			// Waits for the submitter to make room, unless it is waiting for us to stop
+			while (!__results.push(result) && !__is_stopping.load(std::memory_order_acquire))
+				std::this_thread::yield();
+		}
+
+		if (has_played) {
+			__snapshots->publish(*__game);
+			idle_spins = 0;
+		}
+		// An action submitted right before stop() may only show up now
+		else if (__is_stopping.load(std::memory_order_acquire)) {
+			if (__actions.empty())
+				break;
+		}
+		else if (++idle_spins < spins_before_nap) {
+			std::this_thread::yield();
+		}
+		else {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+}
+
+MineSweeper_NS_End
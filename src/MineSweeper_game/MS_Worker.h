@@ -0,0 +1,58 @@
+#pragma once
+#include "MS_Snapshot.h"
+#include "MS_Queue.h"
+#include <thread>
+
+MineSweeper_NS_Begin
+
+struct Action_result
+{
+	Action_type Type;
+	Pos Cell;
+	Action_outcome Outcome;
+	// Mine the action exploded, valid if Outcome is Mine_hit
+	Pos ExplodedCell;
+};
+
+// Runs a single action on game, e.g. on the UI thread when there is no worker
+Action_result run_action(MineSweeper& game, const Action& action);
+
+// Engine thread that plays the player's actions, so an expensive move never stalls the thread that submits it.
+// Actions come in through a lock-free queue and their results go back through another one, the board is published to
+// a Snapshot_buffer after every batch of actions. While the worker runs, the game and the owner side of the buffer
+// belong to it, nothing else may change them or read the board
+class Game_worker
+{
+public:
+	static constexpr size_t s_QUEUE_SIZE{ 256 };
+
+public:
+	Game_worker() = default;
+	~Game_worker() { stop(); }
+	Game_worker(const Game_worker&) = delete;
+	Game_worker& operator=(const Game_worker&) = delete;
+
+	// Publishes game to snapshots before it returns, e.g. after a whole board change made while the worker was stopped
+	void start(MineSweeper& game, Snapshot_buffer& snapshots);
+	// Runs the actions already submitted, then gives the game back. Results that don't fit in their queue are dropped
+	void stop();
+	bool is_running() const { return __worker_thread.joinable(); }
+
+	// Submitting side, returns false if the queue is full
+	bool submit(const Action& action) { return __actions.push(action); }
+	// Results in submission order, returns false if there is none yet
+	bool poll(Action_result& result) { return __results.pop(result); }
+
+private:
+	void _run();
+
+private:
+	Spsc_queue<Action, s_QUEUE_SIZE> __actions;
+	Spsc_queue<Action_result, s_QUEUE_SIZE> __results;
+	MineSweeper* __game{};
+	Snapshot_buffer* __snapshots{};
+	std::atomic<bool> __is_stopping{};
+	std::thread __worker_thread;
+};
+
+MineSweeper_NS_End
@@ -1,263 +1,607 @@
 #include "MineSweeper.h"
-#include <stdlib.h>
-#include <time.h>
 #include <iostream>
 #include <algorithm>
 #include <random>
-#include <thread>
-
-time_t seed{};
+#include <cstdlib>
+#include <limits>
 
 MineSweeper_NS_Begin
 
 MineSweeper::MineSweeper(const Difficulty _diff)
-	: __grid{ (size_t)MineSweeper::s_Preset_Grid_sizes[(size_t)_diff].y, Grid_row((size_t)MineSweeper::s_Preset_Grid_sizes[(size_t)_diff].x, {Cell_State::Unsweeped, 0}) },
-	__remaining_bombs{}, __remaining_cells{}, __exploded_bombs{}, __bombs_count{}, __flagged_count{}, __diff {_diff}, __is_initialized{}, __is_game_over{}
+	: __grid{}, __width{}, __height{}, __neighborhood{}, __is_mine_list_valid{},
+	__remaining_bombs{}, __exploded_bombs{}, __remaining_cells{}, __bombs_count{}, __flagged_count{}, __diff {_diff}, __is_initialized{}, __is_game_over{}, __seed{}, __seed_source{}, __is_history_complete{}, __version{}, __tiles_base_version{}, __tile_chunks{}, __tile_rows{}, __tile_cols{}, __next_reveal{}, __events{}, __was_won{}
 {
 	const auto& grid_size = MineSweeper::s_Preset_Grid_sizes[(size_t)__diff];
 	const auto& bomb_ratio = MineSweeper::s_Preset_Bomb_ratio[(size_t)__diff];
 
-	__bombs_count = round(grid_size.x * grid_size.y * bomb_ratio);
+	__bombs_count = (Cell_Count)round(grid_size.x * grid_size.y * bomb_ratio);
 	__remaining_bombs = __bombs_count;
 
-	__remaining_cells = grid_size.x * grid_size.y;
-}
+	__remaining_cells = (Cell_Count)grid_size.x * grid_size.y;
 
-void MineSweeper::_place_bombs(const Pos& start_pos) {
-	Cell_Value placed_bombs = 0;
-	seed = time(NULL);
-	srand(seed);
-	//srand(0);
-	const Pos grid_size{ width(), height() };
+	std::random_device rd;
+	__seed_source = ((uint64_t)rd() << 32) | rd();
+	__seed = splitmix64(__seed_source);
 
-	auto is_adjacent_to_start = [&start_pos](const Pos& pos) {
-		if ((pos.x <= start_pos.x + 1) && (pos.x >= start_pos.x - 1) && (pos.y <= start_pos.y + 1) && (pos.y >= start_pos.y - 1))
-			return true;
+	_resize_grid(grid_size.y, grid_size.x);
+}
 
-		return false;
-		};
+// Reuses the storage of the current board, the allocator is only hit when the new board is bigger than any before
+void MineSweeper::_resize_grid(const Cell_Value rows, const Cell_Value cols)
+{
+	__random_flags.clear();
+	if (!is_mapped() && rows == __height && cols == __width) {
+		_clear_board();
+		_reset_history(true);
+		return;
+	}
 
-	while (__bombs_count != placed_bombs) {
-		Pos bomb_pos{ rand() % grid_size.x, rand() % grid_size.y };
-		// Start pos must be 0
-		if (is_bomb(bomb_pos) || is_adjacent_to_start(bomb_pos))
-			continue;
+	_close_mapped_game();
+
+	__height = rows;
+	__width = cols;
+	__neighborhood = make_square_neighborhood(cols);
+	__grid.assign((size_t)rows * cols, Cell{});
+	__mines.resize(rows, cols);
+	__mine_indices.clear();
+	__is_mine_list_valid = true;
+	_reset_history(true);
+}
 
-		__grid.at(bomb_pos.y).at(bomb_pos.x).value = s_BOMB;
-		placed_bombs++;
+// Turns every cell back to unsweeped. When the journal holds every change since the board was last
+// clean, rewinding it only touches the cells that changed
+void MineSweeper::_reset_states()
+{
+	if (__is_history_complete) {
+		Game_counters counters{};
+		while (__journal.undo(__grid.data(), counters, [](const size_t, const Cell, const Cell) {}));
+		return;
 	}
+
+	for (auto& cell : __grid)
+		cell.set_state(Cell_State::Unsweeped);
 }
 
-void MineSweeper::_calculate_adjacent_bombs(const Pos& cell_pos) {
-	auto& cell = __grid.at(cell_pos.y).at(cell_pos.x);
-	cell.value = 0;
+// Clears the mines and counts as well. Boards with a mine list only clear the 3x3 area of every mine,
+// the others (dense, mapped or edited) clear every cell
+void MineSweeper::_clear_board()
+{
+	if (!__is_mine_list_valid || __mine_indices.size() * 9 >= __grid.size()) {
+		for (auto& cell : __grid)
+			cell.clear();
+	}
+	else {
+		_reset_states();
+		_visit_board([&](const auto& board) {
+			for (const size_t index : __mine_indices) {
+				__grid[index].clear();
+				for_each_neighbor(board, index, [&](const size_t adj_index) { __grid[adj_index].clear(); });
+			}
+		});
+	}
 
-	for (Cell_Value i{}; i < 3; i++) {
-		if (cell_pos.y - 1 + i < 0 || cell_pos.y - 1 + i >= __grid.size())
-			continue;
-		for (Cell_Value j{}; j < 3; j++) {
-			if (cell_pos.x - 1 + j < 0 || cell_pos.x - 1 + j >= __grid[0].size())
-				continue;
+	__mines.clear();
+	__mine_indices.clear();
+	__is_mine_list_valid = true;
+}
 
-			if (is_bomb({ cell_pos.x - 1 + j, cell_pos.y - 1 + i }))
-				cell.value++;
+// Picks __bombs_count distinct cells uniformly among the cells outside the 3x3 area around start_pos.
+// Sparse boards use Floyd's sampling over the allowed cells: one draw per mine, and the mine bits of the board are
+// the set of picked cells. Dense and mapped boards use selection sampling instead: one draw per cell in board order,
+// so the board is written front to back rather than at random, which keeps large boards in cache and mapped ones
+// off random page faults. Neither needs memory besides the board at any size or density.
+// The generator is reseeded with __seed first, the board only depends on (seed, size, mines, start_pos)
+// Sparse and mapped boards update the counts of the 8 neighbors of every mine as it is placed,
+// dense ones count the whole board at once after placement.
+void MineSweeper::_place_bombs(const Pos& start_pos) {
+	__rng.seed(__seed);
+
+	// Cells of the start area, sorted, they are skipped when mapping a slot to a cell
+	size_t excluded[9]{};
+	size_t excluded_count{};
+	auto exclude = [&](const size_t index) {
+		size_t i = excluded_count++;
+		for (; i > 0 && excluded[i - 1] > index; i--)
+			excluded[i] = excluded[i - 1];
+		excluded[i] = index;
+	};
+	const size_t start_index = _index(start_pos.y, start_pos.x);
+	exclude(start_index);
+	_visit_board([&](const auto& board) { for_each_neighbor(board, start_index, exclude); });
+
+	const size_t allowed_cells = __grid.size() - excluded_count;
+	const size_t mines = (size_t)__bombs_count;
+	if (mines > allowed_cells)
+		throw std::logic_error("MineSweeper: more mines than cells outside the start area");
+
+	auto slot_to_index = [&](size_t slot) {
+		for (size_t i{}; i < excluded_count; i++) {
+			if (excluded[i] <= slot)
+				slot++;
+		}
+		return slot;
+	};
+
+	if (_keeps_mine_list())
+		__mine_indices.reserve(mines);
+	else
+		__is_mine_list_valid = false;
+
+	const bool is_dense = mines * 16 >= __grid.size();
+	const bool incremental_counts = is_mapped() || !is_dense;
+	auto place = [&](const size_t index) {
+		if (incremental_counts) {
+			_add_mine(index);
+		}
+		else {
+			__grid[index].set_bomb(true);
+			__mines.set((Cell_Value)(index / __width), (Cell_Value)(index % __width));
+		}
+	};
+
+	if (is_dense || is_mapped()) {
+		// Take each allowed cell with probability (mines left) / (allowed cells left). Every subset of allowed cells is equally likely
+		size_t mines_left = mines;
+		size_t cells_left = allowed_cells;
+		size_t next_excluded{};
+		for (size_t index{}; mines_left; index++) {
+			if (next_excluded < excluded_count && excluded[next_excluded] == index) {
+				next_excluded++;
+				continue;
+			}
+			if (__rng.bounded(cells_left--) < mines_left) {
+				place(index);
+				mines_left--;
+			}
 		}
 	}
+	else {
+		// Draw t in [0, j], take j instead if t was taken already. Every subset of allowed cells is equally likely
+		for (size_t j = allowed_cells - mines; j < allowed_cells; j++) {
+			const size_t t = (size_t)__rng.bounded(j + 1);
+			const size_t index = slot_to_index(t);
+			place(__grid[index].is_bomb() ? slot_to_index(j) : index);
+		}
+	}
+
+	if (!incremental_counts)
+		count_adjacent_mines(__mines, __grid.data(), __count_planes);
 }
 
-void MineSweeper::_sweep_zeros(const Pos& cell_pos)
+void MineSweeper::_adjust_adjacent_counts(const size_t index, const int delta)
 {
-	auto& cell = __grid.at(cell_pos.y).at(cell_pos.x);
+	_visit_board([&](const auto& board) { adjust_adjacent_counts(board, __grid.data(), index, delta); });
+}
 
-	for (Cell_Value i{}; i < 3; i++) {
-		auto current_cell_row = cell_pos.y - 1 + i;
-		if (current_cell_row < 0 || current_cell_row >= __grid.size())
-			continue;
-		for (Cell_Value j{}; j < 3; j++) {
-			auto current_cell_col = cell_pos.x - 1 + j;
-			if (current_cell_col < 0 || current_cell_col >= __grid[0].size())
-				continue;
+// Rebuilds a dropped mine list, if the board keeps one, from the bitplane or with one scan of a mapped board
+void MineSweeper::_refresh_mine_list()
+{
+	if (__is_mine_list_valid || !_keeps_mine_list())
+		return;
 
-			auto& adj_cell = __grid.at(current_cell_row).at(current_cell_col);
+	__mine_indices.clear();
+	_for_each_mine_index([&](const size_t index) { __mine_indices.push_back(index); });
+	__is_mine_list_valid = true;
+}
 
-			if (adj_cell.value == 0 && adj_cell.state == Cell_State::Unsweeped) {
-				adj_cell.state = Cell_State::Sweeped;
-				__remaining_cells--;
-				//_sweep_all_adjacent({ current_cell_col, current_cell_row });
-				_sweep_zeros({ current_cell_col, current_cell_row });
-			}
-			else if (cell.value == 0 && adj_cell.state == Cell_State::Unsweeped) {
-				adj_cell.state = Cell_State::Sweeped;
-				__remaining_cells--;
-			}
-		}
-	}
+void MineSweeper::_add_mine(const size_t index)
+{
+	__grid[index].set_bomb(true);
+	if (!is_mapped())
+		__mines.set((Cell_Value)(index / __width), (Cell_Value)(index % __width));
+	if (__is_mine_list_valid)
+		__mine_indices.push_back(index);
+	_adjust_adjacent_counts(index, +1);
 }
 
-void MineSweeper::_sweep_all_adjacent(const Pos& cell_pos)
+// Finding the mine in the list would be O(mines), the list is dropped instead and rebuilt when it is needed next
+void MineSweeper::_remove_mine(const size_t index)
 {
-	for (Cell_Value i{}; i < 3; i++) {
-		auto current_cell_row = cell_pos.y - 1 + i;
-		if (current_cell_row < 0 || current_cell_row >= __grid.size())
-			continue;
-		for (Cell_Value j{}; j < 3; j++) {
-			auto current_cell_col = cell_pos.x - 1 + j;
-			if (current_cell_col < 0 || current_cell_col >= __grid[0].size())
-				continue;
+	__grid[index].set_bomb(false);
+	if (!is_mapped())
+		__mines.reset((Cell_Value)(index / __width), (Cell_Value)(index % __width));
+	__mine_indices.clear();
+	__is_mine_list_valid = false;
+	_adjust_adjacent_counts(index, -1);
+}
 
-			auto& cell = __grid.at(current_cell_row).at(current_cell_col);
-			cell.state = Cell_State::Sweeped;
-		}
-	}
+// An edited board is a generated one, the first sweep must not place mines on top of the edits.
+// Called once the edit is known to change the board, a rejected edit leaves the board and its history alone
+void MineSweeper::_begin_edit()
+{
+	_drop_history(false);
+	if (__is_initialized)
+		return;
+
+	__bombs_count = 0;
+	__remaining_bombs = -__flagged_count;
+	__is_initialized = true;
+}
+
+void MineSweeper::_on_mine_edited(const size_t index)
+{
+	_on_cell_changed(index, Game_event_type::Cell_edited);
+	_visit_board([&](const auto& board) {
+		for_each_neighbor(board, index, [&](const size_t adj_index) { _on_cell_changed(adj_index, Game_event_type::Cell_edited); });
+	});
+}
+
+bool MineSweeper::add_mine(const Pos& cell_pos)
+{
+	const auto index = _checked_index(cell_pos.y, cell_pos.x);
+	if (__grid[index].is_bomb())
+		return false;
+
+	_begin_edit();
+	_add_mine(index);
+	_on_mine_edited(index);
+	__bombs_count++;
+	__remaining_bombs++;
+	return true;
+}
+
+bool MineSweeper::remove_mine(const Pos& cell_pos)
+{
+	const auto index = _checked_index(cell_pos.y, cell_pos.x);
+	if (!__grid[index].is_bomb())
+		return false;
+
+	_begin_edit();
+	_remove_mine(index);
+	_on_mine_edited(index);
+	__bombs_count--;
+	__remaining_bombs--;
+	return true;
+}
+
+bool MineSweeper::move_mine(const Pos& from, const Pos& to)
+{
+	const auto from_index = _checked_index(from.y, from.x);
+	const auto to_index = _checked_index(to.y, to.x);
+	if (!__grid[from_index].is_bomb() || __grid[to_index].is_bomb())
+		return false;
+
+	_begin_edit();
+	_remove_mine(from_index);
+	_add_mine(to_index);
+	_on_mine_edited(from_index);
+	_on_mine_edited(to_index);
+	return true;
+}
+
+bool MineSweeper::relocate_mine(const Pos& cell_pos)
+{
+	const auto index = _checked_index(cell_pos.y, cell_pos.x);
+	if (!__grid[index].is_bomb() || (size_t)__bombs_count >= __grid.size())
+		return false;
+
+	// Rejection sampling, expected O(1) tries unless the board is almost full of mines
+	size_t target{};
+	do {
+		target = (size_t)__rng.bounded(__grid.size());
+	} while (__grid[target].is_bomb());
+
+	_begin_edit();
+	_remove_mine(index);
+	_add_mine(target);
+	_on_mine_edited(index);
+	_on_mine_edited(target);
+	return true;
+}
+
+Cell_Count MineSweeper::_sweep_zeros(const size_t start_index)
+{
+	return _visit_board([&](const auto& board) {
+		return sweep_zeros(board, __grid.data(), __reveal_queue, start_index, [this](const size_t index, const Cell before) {
+			__journal.record(index, before, __grid[index]);
+			_on_cell_changed(index, Game_event_type::Cell_revealed);
+		});
+	});
 }
 
 // Re-Playing the current game without changing it
 void MineSweeper::restart_game()
 {
-	const auto& grid_size = MineSweeper::s_Preset_Grid_sizes[(size_t)__diff];
-
 	__remaining_bombs = __bombs_count;
 	__exploded_bombs = 0;
 	__flagged_count = 0;
-	__remaining_cells = grid_size.x * grid_size.y;
+	__remaining_cells = get_cell_count();
 	__is_initialized = true;
 	__is_game_over = false;
 
-	for (auto& row : __grid) {
-		for (auto& cell : row) {
-			cell.state = Cell_State::Unsweeped;
-		}
- 	}
+	_reset_states();
+	_reset_history(true);
 
 	clear_timer();
 }
 
 void MineSweeper::new_game()
 {
+	__seed = splitmix64(__seed_source);
 	__remaining_bombs = __bombs_count;
 	__exploded_bombs = 0;
 	__flagged_count = 0;
-	__remaining_cells = height() * width();
+	__remaining_cells = get_cell_count();
 	__is_initialized = false;
 	__is_game_over = false;
 
-	for (auto& row : __grid) {
-		for (auto& cell : row) {
-			cell.state = Cell_State::Unsweeped;
-			cell.value = 0;
-		}
-	}
+	_clear_board();
+	_reset_history(true);
 
 	clear_timer();
 }
 
 void MineSweeper::new_game(const Difficulty _diff)
 {
+	__seed = splitmix64(__seed_source);
 	__diff = _diff;
 	const auto& grid_size = MineSweeper::s_Preset_Grid_sizes[(size_t)__diff];
 	const auto& bomb_ratio = MineSweeper::s_Preset_Bomb_ratio[(size_t)__diff];
 
-	__bombs_count = round(grid_size.x * grid_size.y * bomb_ratio);
+	__bombs_count = (Cell_Count)round(grid_size.x * grid_size.y * bomb_ratio);
 	__remaining_bombs = __bombs_count;
 	__exploded_bombs = 0;
 	__flagged_count = 0;
-	__remaining_cells = grid_size.x * grid_size.y;
+	__remaining_cells = (Cell_Count)grid_size.x * grid_size.y;
 	__is_initialized = false;
 	__is_game_over = false;
 
-	__grid = Grid{ (size_t)MineSweeper::s_Preset_Grid_sizes[(size_t)_diff].y, Grid_row((size_t)MineSweeper::s_Preset_Grid_sizes[(size_t)_diff].x, {Cell_State::Unsweeped, 0}) };
+	_resize_grid(grid_size.y, grid_size.x);
 	clear_timer();
 }
 
-void MineSweeper::new_game(const size_t row, const size_t col, const uint16_t mines_count)
+Cell_Count MineSweeper::_checked_cell_count(const size_t row, const size_t col, const Cell_Count mines_count)
 {
+	constexpr size_t max_side = (size_t)std::numeric_limits<Cell_Value>::max();
+	constexpr size_t max_cells = (size_t)std::numeric_limits<Cell_Count>::max();
+
+	if (row == 0 || col == 0)
+		throw std::invalid_argument("MineSweeper: grid must have at least one row and one column");
+	if (row > max_side || col > max_side || row > max_cells / col)
+		throw std::invalid_argument("MineSweeper: grid is too large");
+
+	const Cell_Count cells = (Cell_Count)(row * col);
+	// The 3x3 area around the first sweep never holds a mine
+	if (mines_count < 0 || cells < 9 || mines_count > cells - 9)
+		throw std::invalid_argument("MineSweeper: too many mines for the grid");
+
+	return cells;
+}
+
+void MineSweeper::new_game(const size_t row, const size_t col, const Cell_Count mines_count)
+{
+	const Cell_Count cells = _checked_cell_count(row, col, mines_count);
+
+	__seed = splitmix64(__seed_source);
 	__diff = Difficulty::Custom;
 
 	__bombs_count = mines_count;
 	__remaining_bombs = __bombs_count;
 	__exploded_bombs = 0;
 	__flagged_count = 0;
-	__remaining_cells = row * col;
+	__remaining_cells = cells;
 	__is_initialized = false;
 	__is_game_over = false;
 
-	__grid = Grid{ row, Grid_row(col, {Cell_State::Unsweeped, 0}) };
+	_resize_grid((Cell_Value)row, (Cell_Value)col);
 	clear_timer();
 }
 
-void MineSweeper::randomly_flag_mine_count()
+void MineSweeper::_attach_mapped_grid(Mapped_file& file, const Cell_Value rows, const Cell_Value cols)
 {
+	_close_mapped_game();
+	__board_file.swap(file);
+
+	__height = rows;
+	__width = cols;
+	__neighborhood = make_square_neighborhood(cols);
+	__grid.attach((Cell*)(__board_file.data() + BOARD_FILE_CELLS_OFFSET), (size_t)rows * cols);
+	__mines.resize(0, 0);
+	__mine_indices.clear();
+	__is_mine_list_valid = false;
+	// The random flags were indices of the previous grid
+	__random_flags.clear();
+	_reset_history(false);
+}
+
+void MineSweeper::_close_mapped_game()
+{
+	if (!is_mapped())
+		return;
+
+	sync_mapped_game();
+	__board_file.close();
+}
+
+void MineSweeper::new_mapped_game(const char* path, const size_t row, const size_t col, const Cell_Count mines_count)
+{
+	const Cell_Count cells = _checked_cell_count(row, col, mines_count);
+
+	// A new file reads as zeros, which are clear unsweeped cells
+	Mapped_file file;
+	file.create(path, BOARD_FILE_CELLS_OFFSET + (size_t)cells);
+
+	auto& header = *(Board_file_header*)file.data();
+	std::copy(std::begin(BOARD_FILE_MAGIC), std::end(BOARD_FILE_MAGIC), header.Magic);
+	header.Version = BOARD_FILE_VERSION;
+	header.Width = (Cell_Value)col;
+	header.Height = (Cell_Value)row;
+
+	_attach_mapped_grid(file, (Cell_Value)row, (Cell_Value)col);
+	// The new file has no mines, the list is complete
+	__is_mine_list_valid = true;
+
+	__seed = splitmix64(__seed_source);
+	__diff = Difficulty::Custom;
+
+	__bombs_count = mines_count;
+	__remaining_bombs = __bombs_count;
+	__exploded_bombs = 0;
 	__flagged_count = 0;
+	__remaining_cells = cells;
+	__is_initialized = false;
+	__is_game_over = false;
 
-	const Pos grid_size{ width(), height() };
+	// Nothing was played in the new file yet
+	__is_history_complete = true;
 
-	while (__bombs_count != __flagged_count) {
-		Pos flag_pos{ rand() % grid_size.x, rand() % grid_size.y };
-		auto& cell = __grid.at(flag_pos.y).at(flag_pos.x);
-		// Start pos must be 0
-		if (cell.is_marked())
+	clear_timer();
+	sync_mapped_game();
+}
+
+void MineSweeper::open_mapped_game(const char* path)
+{
+	Mapped_file file;
+	file.open(path);
+
+	if (file.size() < BOARD_FILE_CELLS_OFFSET)
+		throw std::runtime_error("MineSweeper: not a board file");
+
+	const auto& header = *(const Board_file_header*)file.data();
+	const size_t max_cells = file.size() - BOARD_FILE_CELLS_OFFSET;
+	if (!std::equal(std::begin(BOARD_FILE_MAGIC), std::end(BOARD_FILE_MAGIC), header.Magic) || header.Version != BOARD_FILE_VERSION ||
+		header.Width <= 0 || header.Height <= 0 || (size_t)header.Height > max_cells / (size_t)header.Width)
+		throw std::runtime_error("MineSweeper: not a board file");
+
+	// Preset boards are dispatched on their compile-time size, it has to match
+	Difficulty diff = (Difficulty)header.Diff;
+	if (diff >= Difficulty(0) && diff < Difficulty::Count) {
+		const auto& grid_size = s_Preset_Grid_sizes[(size_t)diff];
+		if (grid_size.x != header.Width || grid_size.y != header.Height)
+			diff = Difficulty::Custom;
+	}
+	else {
+		diff = Difficulty::Custom;
+	}
+
+	// Closes the current mapped game with its own counters, header stays valid, the mapping just changes owner
+	_attach_mapped_grid(file, header.Height, header.Width);
+
+	__diff = diff;
+	__seed = header.Seed;
+	__bombs_count = header.BombsCount;
+	__remaining_bombs = header.RemainingBombs;
+	__exploded_bombs = header.ExplodedBombs;
+	__remaining_cells = header.RemainingCells;
+	__flagged_count = header.FlaggedCount;
+	__is_initialized = header.IsInitialized;
+	__is_game_over = header.IsGameOver;
+
+	clear_timer();
+	__elapsed_time = header.ElapsedTime;
+}
+
+void MineSweeper::sync_mapped_game()
+{
+	if (!is_mapped())
+		return;
+
+	auto& header = _mapped_header();
+	header.Diff = (int32_t)__diff;
+	header.Seed = __seed;
+	header.BombsCount = __bombs_count;
+	header.RemainingBombs = __remaining_bombs;
+	header.ExplodedBombs = __exploded_bombs;
+	header.RemainingCells = __remaining_cells;
+	header.FlaggedCount = __flagged_count;
+	header.ElapsedTime = __elapsed_time;
+	header.IsInitialized = __is_initialized;
+	header.IsGameOver = __is_game_over;
+
+	__board_file.flush();
+}
+
+void MineSweeper::randomly_flag_mine_count()
+{
+	_reset_history(false);
+
+	// Newest flags first, the list is in random order so any suffix is a uniform pick
+	while (__flagged_count > __bombs_count && !__random_flags.empty()) {
+		assert(__random_flags.back() < __grid.size() && "MineSweeper: random flag of another grid");
+		auto& cell = __grid[__random_flags.back()];
+		__random_flags.pop_back();
+		if (!cell.is_marked())
+			continue;
+
+		cell.set_state(Cell_State::Unsweeped);
+		__flagged_count--;
+	}
+
+	while (__flagged_count < __bombs_count) {
+		const size_t index = (size_t)__rng.bounded(__grid.size());
+		auto& cell = __grid[index];
+		if (cell.state() != Cell_State::Unsweeped)
 			continue;
 
-		cell.state = Cell_State::Marked;
+		cell.set_state(Cell_State::Marked);
+		__random_flags.push_back(index);
 		__flagged_count++;
 	}
 }
 
 void MineSweeper::clear_flags()
 {
-	for (auto& row: __grid) {
-		for (auto& cell : row) {
-			if (cell.is_marked())
-				cell.state = Cell_State::Unsweeped;
-		}
+	_reset_history(false);
+	for (auto& cell : __grid) {
+		if (cell.is_marked())
+			cell.set_state(Cell_State::Unsweeped);
 	}
+	__random_flags.clear();
 
 	__flagged_count = 0;
 }
 
+void MineSweeper::set_mine_count(const Cell_Count mines_count)
+{
+	if (__is_initialized)
+		throw std::logic_error("MineSweeper: the board is already generated");
+	_checked_cell_count((size_t)__height, (size_t)__width, mines_count);
+
+	__remaining_bombs += mines_count - __bombs_count;
+	__bombs_count = mines_count;
+}
+
 void MineSweeper::_print(bool cheat_on)
 {
-	std::cout << ">> Seed: " << seed << '\n';
+	std::cout << ">> Seed: " << __seed << '\n';
 	std::cout << ">> Remaining bombs: " << __remaining_bombs << '\n';
 	std::cout << ">> Remaining cells: " << __remaining_cells << '\n';
 	std::cout << "    ";
-	for (size_t i = 0; i < __grid.at(0).size(); i++)
+	for (Cell_Value i = 0; i < __width; i++)
 	{
 		std::cout << " " << i << " ";
 	}
-	std::cout << '\n' << std::string(3 * (__grid.at(0).size() + 2), '-') << '\n';
+	std::cout << '\n' << std::string(3 * (__width + 2), '-') << '\n';
 
-	size_t row_count{};
-	for (const auto& row : __grid) {
+	for (Cell_Value row_count{}; row_count < __height; row_count++) {
 		std::cout << " " << row_count << " |";
-		for (const auto& cell : row) {
+		for (const auto& cell : get_row(row_count)) {
 			if (!cheat_on) {
-				if (cell.state == Cell_State::Sweeped) {
-					if (cell.value == s_BOMB)
-						std::cout << " " << (char)cell.value << " ";
+				if (cell.state() == Cell_State::Sweeped) {
+					if (cell.is_bomb())
+						std::cout << " " << (char)cell.value() << " ";
 					else
-						std::cout << " " << cell.value << " ";
+						std::cout << " " << cell.value() << " ";
 				}
 				else {
 					std::cout << "[ ]";
 				}
 			}
 			else {
-				if (cell.value == s_BOMB)
-					std::cout << " " << (char)cell.value << " ";
+				if (cell.is_bomb())
+					std::cout << " " << (char)cell.value() << " ";
 				else
-					std::cout << " " << cell.value << " ";
+					std::cout << " " << cell.value() << " ";
 			}
 
 		}
 		std::cout << "| " << row_count << " ";
-		row_count++;
 		std::cout << '\n';
 	}
 
-	std::cout << std::string(3 * (__grid.at(0).size() + 2), '-') << '\n';
+	std::cout << std::string(3 * (__width + 2), '-') << '\n';
 	std::cout << "    ";
-	for (size_t i = 0; i < __grid.at(0).size(); i++)
+	for (Cell_Value i = 0; i < __width; i++)
 	{
 		std::cout << " " << i << " ";
 	}
@@ -269,28 +613,29 @@ void MineSweeper::_initiailize_grid(const Pos& start_pos)
 {
 	_place_bombs(start_pos);
 
-	for (Cell_Value row{}; row < __grid.size(); row++) {
-		auto& current_row = __grid[row];
-
-		for (Cell_Value col{}; col < current_row.size(); col++) {
-			if (!is_bomb({ col,row }))
-				_calculate_adjacent_bombs({ col,row });
-		}
-	}
-
 	__is_initialized = true;
+	_touch_all_tiles();
 }
 
 bool MineSweeper::sweep(const Pos& cell_pos)
 {
-	if (!__is_initialized)
-		_initiailize_grid(cell_pos);
+	return _sweep(_checked_index(cell_pos.y, cell_pos.x)) != Action_outcome::Mine_hit;
+}
 
-	auto& cell = __grid.at(cell_pos.y).at(cell_pos.x);
-	if (cell.state == Cell_State::Unsweeped) {
-		cell.state = Cell_State::Sweeped;
+Action_outcome MineSweeper::_sweep(const size_t index)
+{
+	if (!__is_initialized)
+		_initiailize_grid(_pos(index));
+
+	auto& cell = __grid[index];
+	if (cell.state() == Cell_State::Unsweeped) {
+		_begin_move();
+		Cell sweeped = cell;
+		sweeped.set_state(Cell_State::Sweeped);
+		_set_cell(index, sweeped);
 		__remaining_cells--;
-		_sweep_zeros(cell_pos);
+		if (cell.value() == 0)
+			__remaining_cells -= _sweep_zeros(index);
 
 		__is_game_over = cell.is_bomb();
 		// This is useful when game might be revived
@@ -299,10 +644,11 @@ bool MineSweeper::sweep(const Pos& cell_pos)
 			__exploded_bombs++;
 			__flagged_count++;
 		}
-		return !__is_game_over;
+		_end_move();
+		return cell.is_bomb() ? Action_outcome::Mine_hit : Action_outcome::Changed;
 	}
 
-	return true;
+	return Action_outcome::Unchanged;
 }
 
 bool MineSweeper::sweep(const Cell_Value row, const Cell_Value col)
@@ -310,44 +656,178 @@ bool MineSweeper::sweep(const Cell_Value row, const Cell_Value col)
 	return sweep({ col, row });
 }
 
+Chord_result MineSweeper::chord(const Pos& cell_pos)
+{
+	return _chord(_checked_index(cell_pos.y, cell_pos.x));
+}
+
+Chord_result MineSweeper::_chord(const size_t index)
+{
+	const Cell cell = __grid[index];
+	if (!cell.is_sweeped() || cell.is_bomb() || cell.adjacent_mines() == 0)
+		return {};
+
+	return _visit_board([&](const auto& board) {
+		Chord_result result{};
+
+		// An exploded mine, left open by a revived game, counts as a flag
+		uint8_t flags{};
+		uint8_t closed{};
+		for_each_neighbor(board, index, [&](const size_t adj_index) {
+			const Cell adj_cell = __grid[adj_index];
+			flags += adj_cell.is_marked() || (adj_cell.is_bomb() && adj_cell.is_sweeped());
+			closed += adj_cell.state() == Cell_State::Unsweeped;
+		});
+		if (flags != cell.adjacent_mines())
+			return result;
+
+		result.Chorded = true;
+		// Nothing to open, no move
+		if (closed == 0)
+			return result;
+
+		const Cell_Count remaining_cells = __remaining_cells;
+
+		_begin_move();
+		for_each_neighbor(board, index, [&](const size_t adj_index) {
+			Cell adj_cell = __grid[adj_index];
+			if (adj_cell.state() != Cell_State::Unsweeped)
+				return;
+
+			adj_cell.set_state(Cell_State::Sweeped);
+			_set_cell(adj_index, adj_cell);
+			__remaining_cells--;
+
+			if (adj_cell.is_bomb()) {
+				__remaining_bombs--;
+				__exploded_bombs++;
+				__flagged_count++;
+				__is_game_over = true;
+
+				result.ExplodedMines++;
+				result.ExplodedCell = _pos(adj_index);
+			}
+			else if (adj_cell.adjacent_mines() == 0) {
+				__remaining_cells -= _sweep_zeros(adj_index);
+			}
+		});
+		_end_move();
+
+		result.RevealedCells = remaining_cells - __remaining_cells;
+		return result;
+	});
+}
+
+Chord_result MineSweeper::chord(const Cell_Value row, const Cell_Value col)
+{
+	return chord({ col, row });
+}
+
 void MineSweeper::mark(const Pos& cell_pos) {
 	if (__flagged_count >= __bombs_count)
 		return;
 
-	auto& cell = __grid.at(cell_pos.y).at(cell_pos.x);
+	const auto index = _checked_index(cell_pos.y, cell_pos.x);
+	Cell cell = __grid[index];
 	if (__remaining_bombs == 0 || cell.is_sweeped())
 		return;
 
+	_begin_move();
 	__remaining_bombs--;
 	__flagged_count++;
-	cell.state = Cell_State::Marked;
+	cell.set_state(Cell_State::Marked);
+	_set_cell(index, cell);
+	_end_move();
 }
 
 void MineSweeper::unmark(const Pos& cell_pos)
 {
-	auto& cell = __grid.at(cell_pos.y).at(cell_pos.x);
+	const auto index = _checked_index(cell_pos.y, cell_pos.x);
+	Cell cell = __grid[index];
 	if (!cell.is_marked())
 		return;
 
+	_begin_move();
 	__remaining_bombs++;
 	__flagged_count--;
-	cell.state = Cell_State::Unsweeped;
+	cell.set_state(Cell_State::Unsweeped);
+	_set_cell(index, cell);
+	_end_move();
 }
 
 void MineSweeper::toggle_mark(const Pos& cell_pos)
 {
-	auto& cell = __grid.at(cell_pos.y).at(cell_pos.x);
+	_toggle_mark(_checked_index(cell_pos.y, cell_pos.x));
+}
+
+bool MineSweeper::_toggle_mark(const size_t index)
+{
+	Cell cell = __grid[index];
 
-	if (cell.state == Cell_State::Marked) {
+	if (cell.state() == Cell_State::Marked) {
+		_begin_move();
 		__remaining_bombs++;
 		__flagged_count--;
-		cell.state = Cell_State::Unsweeped;
+		cell.set_state(Cell_State::Unsweeped);
+		_set_cell(index, cell);
+		_end_move();
+		return true;
 	}
-	else if (cell.state == Cell_State::Unsweeped && __flagged_count < __bombs_count) {
+	else if (cell.state() == Cell_State::Unsweeped && __flagged_count < __bombs_count) {
+		_begin_move();
 		__remaining_bombs--;
 		__flagged_count++;
-		cell.state = Cell_State::Marked;
+		cell.set_state(Cell_State::Marked);
+		_set_cell(index, cell);
+		_end_move();
+		return true;
+	}
+
+	return false;
+}
+
+size_t MineSweeper::apply(Span<const Action> actions, Span<Action_outcome> outcomes, const bool stop_on_mine)
+{
+	if (!outcomes.empty() && outcomes.size() < actions.size())
+		throw std::invalid_argument("MineSweeper: fewer outcomes than actions");
+
+	size_t applied{};
+	for (; applied < actions.size(); applied++) {
+		const Action& action = actions[applied];
+		Action_outcome outcome = Action_outcome::Out_of_grid;
+
+		if (action.Cell.y >= 0 && action.Cell.y < __height && action.Cell.x >= 0 && action.Cell.x < __width) {
+			const size_t index = _index(action.Cell.y, action.Cell.x);
+			switch (action.Type) {
+			case Action_type::Sweep:
+				outcome = _sweep(index);
+				break;
+			case Action_type::Toggle_mark:
+				outcome = _toggle_mark(index) ? Action_outcome::Changed : Action_outcome::Unchanged;
+				break;
+			case Action_type::Chord: {
+				const auto result = _chord(index);
+				outcome = result.ExplodedMines ? Action_outcome::Mine_hit : result.RevealedCells ? Action_outcome::Changed : Action_outcome::Unchanged;
+				break;
+			}
+			}
+		}
+
+		if (!outcomes.empty())
+			outcomes[applied] = outcome;
+
+		if (stop_on_mine && outcome == Action_outcome::Mine_hit) {
+			applied++;
+			break;
+		}
+	}
+
+	if (!outcomes.empty()) {
+		for (size_t i = applied; i < actions.size(); i++)
+			outcomes[i] = Action_outcome::Not_applied;
 	}
+
+	return applied;
 }
 
 void MineSweeper::toggle_mark(const Cell_Value row, const Cell_Value col)
@@ -357,46 +837,164 @@ void MineSweeper::toggle_mark(const Cell_Value row, const Cell_Value col)
 
 void MineSweeper::reveal_bombs()
 {
-	for (auto& row : __grid) {
-		for (auto& cell : row) {
-			if (cell.is_bomb() && !cell.is_marked())
-				cell.reveal();
+	_refresh_mine_list();
+	_begin_move();
+	_for_each_mine_index([&](const size_t index) {
+		Cell cell = __grid[index];
+		if (!cell.is_marked() && !cell.is_sweeped()) {
+			cell.reveal();
+			_set_cell(index, cell, Game_event_type::Mine_revealed);
 		}
-	}
+	});
+	_end_move();
 }
 
-void MineSweeper::reveal_bombs_timer(const sc::milliseconds time_ms)
+bool MineSweeper::undo()
 {
-	Cell** all_mines = new Cell*[__bombs_count];
-	int array_length = 0;
+	Game_counters counters{};
+	if (!__journal.undo(__grid.data(), counters, [this](const size_t index, const Cell before, const Cell after) { _on_cell_changed(index, cell_event_type(before, after)); }))
+		return false;
 
-	for (int row{}; row < __grid.size(); row++) {
-		for (int col{}; col < __grid[0].size(); col++) {
-			Cell* cell = &__grid[row][col];
-			if (cell->is_bomb()) {
-				if(array_length < __bombs_count)
-					all_mines[array_length] = cell;
-				array_length++;
-			}
-		}
-	}
+	_set_counters(counters);
+	return true;
+}
 
-	int* all_mines_indexes = new int[__bombs_count];
-	for (int i{}; i < __bombs_count; i++)
-		all_mines_indexes[i] = i;
+bool MineSweeper::redo()
+{
+	Game_counters counters{};
+	if (!__journal.redo(__grid.data(), counters, [this](const size_t index, const Cell before, const Cell after) { _on_cell_changed(index, cell_event_type(before, after)); }))
+		return false;
 
-	std::random_device rd;
-	std::mt19937 g(rd());
+	_set_counters(counters);
+	return true;
+}
 
-	std::shuffle(all_mines_indexes, all_mines_indexes + __bombs_count, g);
+void MineSweeper::_begin_move()
+{
+	__journal.begin_move(_counters());
+	__was_won = is_game_won();
+}
 
-	for (int i{}; i < __bombs_count; i++) {
-		all_mines[all_mines_indexes[i]]->reveal();
-		std::this_thread::sleep_for(time_ms / __bombs_count);
+void MineSweeper::_set_cell(const size_t index, const Cell cell, const Game_event_type event)
+{
+	__journal.record(index, __grid[index], cell);
+	__grid[index] = cell;
+	_on_cell_changed(index, event);
+}
+
+void MineSweeper::_on_cell_changed(const size_t index, const Game_event_type type)
+{
+	const Pos pos = _pos(index);
+	const size_t tile = (size_t)(pos.y / s_TILE_SIZE) * __tile_cols + pos.x / s_TILE_SIZE;
+	auto& chunk = __tile_chunks[tile / s_TILE_CHUNK];
+	if (chunk.empty())
+		chunk.resize(s_TILE_CHUNK);
+	chunk[tile % s_TILE_CHUNK] = ++__version;
+	_emit(type, pos);
+}
+
+// O(tiles / s_TILE_CHUNK). Chunks kept from before hold versions below the new base, they read as the base
+void MineSweeper::_touch_all_tiles()
+{
+	__tile_rows = (__height + s_TILE_SIZE - 1) / s_TILE_SIZE;
+	__tile_cols = (__width + s_TILE_SIZE - 1) / s_TILE_SIZE;
+	const size_t tiles = (size_t)__tile_rows * __tile_cols;
+	__tile_chunks.resize((tiles + s_TILE_CHUNK - 1) / s_TILE_CHUNK);
+	__tiles_base_version = ++__version;
+}
+
+void MineSweeper::_end_move()
+{
+	// The journal dropped old moves to fit this one, or all of them for a move too big, restart can't rewind it anymore
+	if (!__journal.end_move(_counters()))
+		__is_history_complete = false;
+	if (!__was_won && is_game_won())
+		_emit(Game_event_type::Game_won, {});
+}
+
+void MineSweeper::_reset_history(const bool is_clean)
+{
+	_drop_history(is_clean);
+	_touch_all_tiles();
+	_emit(Game_event_type::Board_reset, get_grid_size());
+}
+
+void MineSweeper::_drop_history(const bool is_clean)
+{
+	cancel_mine_reveal();
+	__is_history_complete = is_clean;
+	__journal.clear();
+}
+
+void MineSweeper::_set_counters(const Game_counters& counters)
+{
+	__remaining_bombs = counters.remaining_bombs;
+	__exploded_bombs = counters.exploded_bombs;
+	__remaining_cells = counters.remaining_cells;
+	__flagged_count = counters.flagged_count;
+	__is_game_over = counters.is_game_over;
+}
+
+void MineSweeper::_plan_hidden_mines()
+{
+	cancel_mine_reveal();
+	_refresh_mine_list();
+	_for_each_mine_index([&](const size_t index) {
+		const Cell cell = __grid[index];
+		if (!cell.is_marked() && !cell.is_sweeped())
+			__reveal_plan.push_back({ index, 0 });
+	});
+}
+
+void MineSweeper::start_mine_reveal(const Time_t now, const Time_t duration)
+{
+	_plan_hidden_mines();
+	std::shuffle(__reveal_plan.begin(), __reveal_plan.end(), __rng);
+
+	const size_t mines = __reveal_plan.size();
+	for (size_t i{}; i < mines; i++)
+		__reveal_plan[i].time = now + duration * (Time_t)i / (Time_t)mines;
+}
+
+void MineSweeper::start_mine_reveal(const Time_t now, const Time_t duration, const Pos& center)
+{
+	_plan_hidden_mines();
+
+	// Ring of a mine is its distance to center, every ring waits the same time after the previous one
+	const Cell_Value rings = std::max(__width, __height);
+	for (auto& step : __reveal_plan) {
+		const Pos mine = _pos(step.index);
+		const Cell_Value ring = std::max(std::abs(mine.y - center.y), std::abs(mine.x - center.x));
+		step.time = now + duration * (Time_t)(ring - 1) / (Time_t)rings;
 	}
+	std::sort(__reveal_plan.begin(), __reveal_plan.end(), [](const Reveal_step& a, const Reveal_step& b) { return a.time < b.time; });
+}
+
+Cell_Count MineSweeper::advance_mine_reveal(const Time_t now)
+{
+	if (!is_revealing_mines() || __reveal_plan[__next_reveal].time > now)
+		return 0;
+
+	Cell_Count revealed{};
+	for (; __next_reveal < __reveal_plan.size() && __reveal_plan[__next_reveal].time <= now; __next_reveal++) {
+		const size_t index = __reveal_plan[__next_reveal].index;
+		// The player may have changed it since the plan was made, e.g. by undo
+		Cell cell = __grid[index];
+		if (cell.is_marked() || cell.is_sweeped())
+			continue;
+
+		if (revealed++ == 0)
+			_begin_move();
+		cell.reveal();
+		_set_cell(index, cell, Game_event_type::Mine_revealed);
+	}
+	if (revealed)
+		_end_move();
+
+	if (!is_revealing_mines())
+		cancel_mine_reveal();
 
-	delete[] all_mines;
-	delete[] all_mines_indexes;
+	return revealed;
 }
 
 
@@ -1,44 +1,25 @@
 #pragma once
-#include <stdint.h>
+#include "MS_Cell.h"
+#include "MS_Board.h"
+#include "MS_Bitboard.h"
+#include "MS_Random.h"
+#include "MS_MappedFile.h"
+#include "MS_Journal.h"
+#include "MS_Events.h"
 #include <vector>
 #include <chrono>
+#include <stdexcept>
+#include <cassert>
 
 namespace sc = std::chrono;
 
-#define MiSw minesweeper::
-#define MiSw_NS minesweeper
-
-#define MineSweeper_NS_Begin	namespace MiSw_NS {
-#define MineSweeper_NS_End		}
-
 MineSweeper_NS_Begin
 
 class MineSweeper;
-typedef typename int Cell_Value;
-
-enum class Cell_State
-{
-	Unsweeped,
-	Sweeped,
-	Marked,
-
-	Bomb = '*'
-};
-
-struct Cell
-{
-	Cell_State state;
-	Cell_Value value;
-
-	bool is_bomb() const { return value == (Cell_Value)Cell_State::Bomb; }
-	bool is_sweeped() const { return state == Cell_State::Sweeped; }
-	bool is_marked() const { return state == Cell_State::Marked; }
-
-	void reveal() { state = Cell_State::Sweeped; }
-};
 
-typedef typename std::vector<Cell> Grid_row;
-typedef typename std::vector<Grid_row> Grid;
+// Row-major, one contiguous block for the whole board
+typedef Board_storage Grid;
+typedef typename Span<const Cell> Grid_view;
 
 enum class Difficulty
 {
@@ -52,16 +33,22 @@ enum class Difficulty
 	Custom
 };
 
-struct Pos
+// Bounds checking of the cell accessors. Checked throws std::out_of_range for cells out of the grid,
+// Unchecked only asserts, for loops that already know their cells are inside the grid
+enum class Access
 {
-	Cell_Value x;
-	Cell_Value y;
-
-	bool operator==(const Pos& rhs) {
-		return (x == rhs.x && y == rhs.y);
-	}
+	Checked,
+	Unchecked
 };
 
+// Access of the per-cell accessors called in hot loops (renderer, solvers, generation):
+// checked in debug builds, unchecked with asserts in release
+#ifdef _DEBUG
+inline constexpr Access HOT_PATH_ACCESS{ Access::Checked };
+#else
+inline constexpr Access HOT_PATH_ACCESS{ Access::Unchecked };
+#endif
+
 inline constexpr int PLAYER_NAME_MAX_LENGTH{ 20 };
 inline constexpr Cell_Value PLAYER_TIME_NA{ -1 };
 
@@ -76,6 +63,65 @@ struct PlayerStats {
 };
 #pragma pack(pop)
 
+// Layout of a mapped board file: the header, padded to BOARD_FILE_CELLS_OFFSET bytes, then the cells row-major
+#pragma pack(push, 1)
+struct Board_file_header {
+	char Magic[8];
+	uint32_t Version;
+	Cell_Value Width;
+	Cell_Value Height;
+	int32_t Diff;
+	uint64_t Seed;
+
+	Cell_Count BombsCount;
+	Cell_Count RemainingBombs;
+	Cell_Count ExplodedBombs;
+	Cell_Count RemainingCells;
+	Cell_Count FlaggedCount;
+	double ElapsedTime;
+
+	uint8_t IsInitialized;
+	uint8_t IsGameOver;
+};
+#pragma pack(pop)
+
+inline constexpr char BOARD_FILE_MAGIC[8]{ 'M', 'S', 'B', 'O', 'A', 'R', 'D', '\0' };
+inline constexpr uint32_t BOARD_FILE_VERSION{ 1 };
+inline constexpr size_t BOARD_FILE_CELLS_OFFSET{ 128 };
+static_assert(sizeof(Board_file_header) <= BOARD_FILE_CELLS_OFFSET, "Board_file_header overlaps the cells");
+
+// Outcome of a chord, all the cells it opened count as a single move
+struct Chord_result {
+	// false if the cell is not a sweeped number with exactly that many flags around it
+	bool Chorded;
+	Cell_Count RevealedCells;
+	Cell_Count ExplodedMines;
+	// Last mine the chord opened, valid if ExplodedMines != 0
+	Pos ExplodedCell;
+};
+
+enum class Action_type : uint8_t
+{
+	Sweep,
+	Toggle_mark,
+	Chord
+};
+
+struct Action {
+	Action_type Type;
+	Pos Cell;
+};
+
+enum class Action_outcome : uint8_t
+{
+	Unchanged,
+	Changed,
+	Mine_hit,
+	Out_of_grid,
+	// Not run, an earlier action hit a mine and apply(...) was asked to stop there
+	Not_applied
+};
+
 class MineSweeper
 {
 public:
@@ -85,19 +131,34 @@ public:
 public:
 	static constexpr Cell_Value s_BOMB{ '*' };
 	static constexpr Pos s_Preset_Grid_sizes[(size_t)Difficulty::Count]{ {9,9}, {16,16}, {30,16}, {30,20} };
+	static constexpr Cell_Value s_TILE_SIZE{ 16 };
 
 private:
 	static constexpr const char* s_Difficulty_str[(size_t)Difficulty::Count]{ "Easy", "Medium", "Hard", "Expert" };
 	// #of cells to #of bombs
 	static constexpr float s_Preset_Bomb_ratio[(size_t)Difficulty::Count]{ 0.11f, 0.156f, 0.206f, 0.241f };
+	// Tiles per chunk of tile versions
+	static constexpr size_t s_TILE_CHUNK{ 4096 };
 
 private:
 	Grid __grid;
-	Cell_Value __remaining_bombs;
-	Cell_Value __exploded_bombs;
-	Cell_Value __remaining_cells;
-	Cell_Value __bombs_count;
-	Cell_Value __flagged_count;
+	Cell_Value __width;
+	Cell_Value __height;
+	// Neighbor table of the current width, used by custom boards, presets have theirs built at compile time
+	Neighborhood __neighborhood;
+	// Mirror of the mine bits of __grid, used to count adjacent mines of the whole board at once
+	Mine_bitplane __mines;
+	// Indices of the mines in no particular order, mine operations cost O(mines) instead of a board scan.
+	// Only sparse boards keep it, mapped ones included, see _keeps_mine_list(), it is never bigger than the bitplane.
+	// Removing a mine drops the list, _refresh_mine_list() rebuilds it when a mine operation needs it
+	std::vector<size_t> __mine_indices;
+	bool __is_mine_list_valid;
+	std::vector<uint64_t> __count_planes;
+	Cell_Count __remaining_bombs;
+	Cell_Count __exploded_bombs;
+	Cell_Count __remaining_cells;
+	Cell_Count __bombs_count;
+	Cell_Count __flagged_count;
 	Difficulty __diff;
 
 	bool __is_initialized;
@@ -108,10 +169,52 @@ private:
 	bool __timer_running;
 
 	Fptr_TimerHandler GetTime;
+	// Work buffer of _sweep_zeros, kept to reuse its capacity between sweeps
+	Sweep_queue __reveal_queue;
+
+	// The board is generated from __seed alone, __seed_source hands out a new seed for every new game
+	uint64_t __seed;
+	uint64_t __seed_source;
+	Xoshiro256ss __rng;
+	// Cells flagged by randomly_flag_mine_count, in random order. Entries whose flag was removed since are skipped
+	std::vector<size_t> __random_flags;
+
+	// Backing file of a mapped board, __grid borrows its cells while it is open
+	Mapped_file __board_file;
+
+	// Moves played since the board was last cleared, restarted or edited
+	Move_journal __journal;
+	// The journal holds every change since all the cells were last unsweeped, rewinding it gives a clean board
+	bool __is_history_complete;
+
+	// Version of the board and of every s_TILE_SIZE x s_TILE_SIZE tile, row-major.
+	// A tile gets the new board version whenever one of its cells changes. A whole board change only raises
+	// __tiles_base_version, the version of a tile is the larger of the two. The tile versions are kept in chunks
+	// of s_TILE_CHUNK tiles, allocated with the first change in one of their tiles: a board that isn't played,
+	// e.g. a huge mapped one just opened, costs no memory for them
+	uint64_t __version;
+	uint64_t __tiles_base_version;
+	std::vector<std::vector<uint64_t>> __tile_chunks;
+	Cell_Value __tile_rows;
+	Cell_Value __tile_cols;
+
+	// Mines of the running reveal plan with their reveal time, in time order. [0, __next_reveal) are done
+	struct Reveal_step
+	{
+		size_t index;
+		Time_t time;
+	};
+	std::vector<Reveal_step> __reveal_plan;
+	size_t __next_reveal;
+
+	// Caller's buffer of change events, nullptr when nobody listens
+	std::vector<Game_event>* __events;
+	bool __was_won;
 public:
 	MineSweeper(const Difficulty _diff);
 	MineSweeper(const Cell_Value rows, const Cell_Value cols, const Cell_Value mines);
 	MineSweeper() = delete;
+	~MineSweeper() { _close_mapped_game(); }
 
 public:
 	// returns true if successful, false if cell was bomb
@@ -127,44 +230,166 @@ public:
 	void toggle_mark(const Pos& cell);
 	void toggle_mark(const Cell_Value row, const Cell_Value col);
 
-	void reveal_bombs();
-	void reveal_bombs_timer(const sc::milliseconds time_ms);
+	// Sweeps every unflagged neighbor of a sweeped number once as many flags as its count are around it,
+	// exploded mines count as flags. Zero neighbors cascade like sweep(...), a wrong flag opens the mine it was hiding.
+	// A chord with nothing to open is not a move
+	Chord_result chord(const Pos& cell);
+	Chord_result chord(const Cell_Value row, const Cell_Value col);
 
-	Cell_State get_state(const Pos cell) const { return __grid.at(cell.y).at(cell.x).state; }
-	Cell_Value get_value(const Pos cell) const { return __grid.at(cell.y).at(cell.x).value; }
+	// Runs a sequence of actions in one call, each one is a move of its own just like the single calls.
+	// Cells out of the grid don't throw, their outcome is Out_of_grid. outcomes is either empty
+	// or receives the outcome of every action, throws std::invalid_argument if it is shorter than actions.
+	// With stop_on_mine nothing runs after the first action that hits a mine.
+	// Returns the number of actions that ran
+	size_t apply(Span<const Action> actions, Span<Action_outcome> outcomes = {}, const bool stop_on_mine = false);
 
-	const Cell& get_cell(const Pos cell_pos) { return __grid.at(cell_pos.y).at(cell_pos.x); }
-	const Cell& get_cell(const Cell_Value row, const Cell_Value col) const { return __grid.at(row).at(col); }
-	Cell& get_cell(const Cell_Value row, const Cell_Value col) { return __grid.at(row).at(col); }
+	void reveal_bombs();
+
+	// Scheduled reveal of the hidden mines, spread over duration from now. The plan is made once,
+	// the caller reveals the mines that are due with advance_mine_reveal(now), e.g. once per frame, nothing ever sleeps.
+	// Mines come in random order, or ring by ring around center. A new plan replaces the running one,
+	// restart_game, new_game(...) and the other whole board changes cancel it
+	void start_mine_reveal(const Time_t now, const Time_t duration);
+	void start_mine_reveal(const Time_t now, const Time_t duration, const Pos& center);
+	// Reveals the mines due at now as one move, returns how many were revealed
+	Cell_Count advance_mine_reveal(const Time_t now);
+	// Stops the plan, the mines already revealed stay revealed
+	void cancel_mine_reveal() { __reveal_plan.clear(); __next_reveal = 0; }
+	bool is_revealing_mines() const { return __next_reveal < __reveal_plan.size(); }
+
+	// Cell accessors, checked by default, e.g. get_cell<HOT_PATH_ACCESS>(row, col) in inner loops
+	template<Access A = Access::Checked>
+	Cell_State get_state(const Pos cell) const { return __grid[_index<A>(cell.y, cell.x)].state(); }
+	template<Access A = Access::Checked>
+	Cell_Value get_value(const Pos cell) const { return __grid[_index<A>(cell.y, cell.x)].value(); }
+
+	template<Access A = Access::Checked>
+	const Cell& get_cell(const Pos cell_pos) const { return __grid[_index<A>(cell_pos.y, cell_pos.x)]; }
+	template<Access A = Access::Checked>
+	const Cell& get_cell(const Cell_Value row, const Cell_Value col) const { return __grid[_index<A>(row, col)]; }
+	// Changes made through the reference are outside the history, restart_game falls back to a full reset
+	template<Access A = Access::Checked>
+	Cell& get_cell(const Cell_Value row, const Cell_Value col) { __is_history_complete = false; return __grid[_index<A>(row, col)]; }
+
+	// Views into the board, no copies are made. Invalidated by new_game(...)
+	template<Access A = Access::Checked>
+	Grid_view get_row(const Cell_Value row) const { return Grid_view(&__grid[_index<A>(row, 0)], __width); }
+	template<Access A = Access::Checked>
+	Grid_view get_column(const Cell_Value col) const { return Grid_view(&__grid[_index<A>(0, col)], __height, __width); }
+	Grid_view get_cells() const { return Grid_view(__grid.data(), __grid.size()); }
 
 	const char* get_diff_str() const { return (__diff < Difficulty::Count && __diff >= Difficulty(0)) ? s_Difficulty_str[(size_t)__diff] : "Custom"; }
-	Pos get_grid_size() const { return (__diff < Difficulty::Count && __diff >= Difficulty(0)) ? s_Preset_Grid_sizes[(size_t)__diff] : Pos{ (Cell_Value)__grid.at(0).size(), (Cell_Value)__grid.size() }; }
+	Pos get_grid_size() const { return Pos{ __width, __height }; }
+	Cell_Count get_cell_count() const { return (Cell_Count)__width * __height; }
 
-	Cell_Value height() const { return __grid.size(); }
-	Cell_Value width() const { return __grid.at(0).size(); }
+	Cell_Value height() const { return __height; }
+	Cell_Value width() const { return __width; }
 
-	Cell_Value get_remaining_bombs() const { return __remaining_bombs; }
-	Cell_Value get_mine_count() const { return __bombs_count; }
+	Cell_Count get_remaining_bombs() const { return __remaining_bombs; }
+	Cell_Count get_mine_count() const { return __bombs_count; }
 	Difficulty get_difficulty() const { return __diff; }
-	Cell_Value get_exploded_mines() const { return __exploded_bombs; }
+	Cell_Count get_exploded_mines() const { return __exploded_bombs; }
+	Cell_Count get_remaining_cells() const { return __remaining_cells; }
+
+	// Calls f(neighbor) for every cell around cell that is inside the grid, e.g. for solvers.
+	// Throws std::out_of_range if cell is out of the grid
+	template<typename F>
+	void for_each_adjacent(const Pos& cell, F&& f) const {
+		const size_t index = _checked_index(cell.y, cell.x);
+		_visit_board([&](const auto& board) {
+			for_each_neighbor(board, index, [&](const size_t adj_index) { f(_pos(adj_index)); });
+		});
+	}
 
-	bool is_bomb(const Pos cell) const { return __grid.at(cell.y).at(cell.x).value == s_BOMB; }
-	bool is_bomb(const Cell_Value row, const Cell_Value col) const { return __grid.at(row).at(col).value == s_BOMB; }
+	// Calls f(mine) for every mine of the board, in no particular order, in O(mines)
+	template<typename F>
+	void for_each_mine(F&& f) const { _for_each_mine_index([&](const size_t index) { f(_pos(index)); }); }
+
+	template<Access A = Access::Checked>
+	bool is_bomb(const Pos cell) const { return __grid[_index<A>(cell.y, cell.x)].is_bomb(); }
+	template<Access A = Access::Checked>
+	bool is_bomb(const Cell_Value row, const Cell_Value col) const { return __grid[_index<A>(row, col)].is_bomb(); }
 	bool is_game_won() const { return (__remaining_cells + __exploded_bombs == __bombs_count); }
 	bool is_game_over() const { return __is_game_over; }
 
-	// Restart the same game
+	// Restart the same game, only the cells changed since it started are touched
 	void restart_game();
-	// new game with the same different difficulty
+	// new game with the same different difficulty, never allocates
 	void new_game();
-	// new game with different difficulty
+	// new game with different difficulty, only allocates if the board is bigger than any before
 	void new_game(const Difficulty _diff);
-	void new_game(const size_t row, const size_t col, const uint16_t mines_count);
+	// Throws std::invalid_argument if a side doesn't fit in Cell_Value, the cell count overflows
+	// or the mines don't fit outside the 3x3 start area
+	void new_game(const size_t row, const size_t col, const Cell_Count mines_count);
 	void revive_game() { __is_game_over = false; }
 
-	// Randomly falgs cells by the number of mines
+	// Mapped boards keep their cells in a file mapped into memory instead of the heap, so the board
+	// may be larger than RAM, the OS pages parts of it in and out as they are touched.
+	// Mapped boards don't keep the mine bitplane, it would take RAM in proportion to the board, only the mine list when sparse.
+	// Any other new_game(...) but new_game() syncs and closes the file.
+
+	// Creates path, overwriting it, and starts a custom game in it. Same arguments and errors as new_game(row, col, mines_count),
+	// throws std::runtime_error if the file can't be created
+	void new_mapped_game(const char* path, const size_t row, const size_t col, const Cell_Count mines_count);
+	// Resumes the game saved in path without reading the board, throws std::runtime_error if it isn't a board file.
+	// The timer is stopped with the elapsed time of the saved game
+	void open_mapped_game(const char* path);
+	// Writes the counters to the file header and flushes the board, e.g. when pausing
+	void sync_mapped_game();
+	bool is_mapped() const { return __board_file.is_open(); }
+
+	// Seed of the current board. The same seed, size, mine count and first sweep always give the same board
+	uint64_t get_seed() const { return __seed; }
+	// Replaces the seed of a board that is not generated yet (before the first sweep)
+	void set_seed(const uint64_t seed) { __seed = seed; }
+
+	// Board editing, the adjacent mine counts are kept up to date with O(1) work per change.
+	// Editing a board before its first sweep turns it into a generated board without mines.
+	// Return false if there was nothing to change, the board and the undo history are left as they were then
+	bool add_mine(const Pos& cell);
+	bool remove_mine(const Pos& cell);
+	bool move_mine(const Pos& from, const Pos& to);
+	// Moves the mine under cell to a random mine free cell, e.g. to make a first sweep safe
+	bool relocate_mine(const Pos& cell);
+
+	// Undo/redo of sweep, chord, mark, unmark, toggle_mark, reveal_bombs and advance_mine_reveal, in time linear in the cells the move changed.
+	// Mines are not part of the history, undoing the first sweep keeps the generated board.
+	// It is cleared by restart_game, new_game(...), board editing, the other whole board changes
+	// and by a move that changes more than Move_journal::s_MAX_CELLS cells, e.g. a huge opening.
+	// It keeps the latest moves up to that many cells, a move that changes nothing isn't an undo step.
+	// Return false if there is nothing to undo / redo
+	bool undo();
+	bool redo();
+	bool can_undo() const { return __journal.can_undo(); }
+	bool can_redo() const { return __journal.can_redo(); }
+
+	// Versions only grow, a consumer that remembers the version it last saw of the board or of a tile
+	// knows it is unchanged if the version is still the same. The board version changes with any change of a cell,
+	// a tile version with any change of one of its cells. Cells changed through the non-const get_cell(...) aren't tracked
+	uint64_t get_version() const { return __version; }
+	uint64_t get_tile_version(const Cell_Value tile_row, const Cell_Value tile_col) const {
+		if (tile_row < 0 || tile_row >= tile_rows() || tile_col < 0 || tile_col >= tile_cols())
+			throw std::out_of_range("MineSweeper: tile out of the grid");
+		const size_t tile = (size_t)tile_row * __tile_cols + tile_col;
+		const auto& chunk = __tile_chunks[tile / s_TILE_CHUNK];
+		return chunk.empty() ? __tiles_base_version : std::max(__tiles_base_version, chunk[tile % s_TILE_CHUNK]);
+	}
+	Cell_Value tile_rows() const { return __tile_rows; }
+	Cell_Value tile_cols() const { return __tile_cols; }
+
+	// Every change made by the following calls is appended to events as it happens, nullptr stops it.
+	// Cell changes come one event per cell, board editing included, whole board changes (restart, new game...) as a single Board_reset.
+	// The buffer is never cleared by the game and must outlive it, or be detached first
+	void set_event_buffer(std::vector<Game_event>* events) { __events = events; }
+
+	// Randomly falgs cells by the number of mines, e.g. to preview a custom board.
+	// Only the difference with the flags it placed before is added or removed, so following
+	// the mine count of a preview costs O(change)
 	void randomly_flag_mine_count();
 	void clear_flags();
+	// Changes the mine count of a board that is not generated yet, in O(1).
+	// Throws std::logic_error once the board is generated, std::invalid_argument if the mines don't fit
+	void set_mine_count(const Cell_Count mines_count);
 
 	void init_timer(const Time_t time_point) { __start_time = time_point; __elapsed_time = 0;  __timer_running = false; }
 	void start_timer() { __timer_running = true; }
@@ -177,11 +402,95 @@ public:
 	void _print(bool cheat_on);
 
 private:
+	size_t _index(const Cell_Value row, const Cell_Value col) const { return (size_t)row * __width + col; }
+	size_t _checked_index(const Cell_Value row, const Cell_Value col) const {
+		if (row < 0 || row >= __height || col < 0 || col >= __width)
+			throw std::out_of_range("MineSweeper: cell out of the grid");
+		return _index(row, col);
+	}
+	template<Access A>
+	size_t _index(const Cell_Value row, const Cell_Value col) const {
+		if constexpr (A == Access::Checked) {
+			return _checked_index(row, col);
+		}
+		else {
+			assert(row >= 0 && row < __height && col >= 0 && col < __width && "MineSweeper: cell out of the grid");
+			return _index(row, col);
+		}
+	}
+	void _resize_grid(const Cell_Value rows, const Cell_Value cols);
+	void _reset_states();
+	void _clear_board();
+	static Cell_Count _checked_cell_count(const size_t row, const size_t col, const Cell_Count mines_count);
+	Board_file_header& _mapped_header() { return *(Board_file_header*)__board_file.data(); }
+	void _attach_mapped_grid(Mapped_file& file, const Cell_Value rows, const Cell_Value cols);
+	void _close_mapped_game();
+
 	void _initiailize_grid(const Pos& start_pos);
+	// Unchecked versions of the moves, index must be inside the grid
+	Action_outcome _sweep(const size_t index);
+	bool _toggle_mark(const size_t index);
+	Chord_result _chord(const size_t index);
 	void _place_bombs(const Pos& start_pos);
-	void _calculate_adjacent_bombs(const Pos& cell);
-	void _sweep_zeros(const Pos& pos);
-	void _sweep_all_adjacent(const Pos& pos);
+	// Fills the plan with the hidden mines, their reveal time is left to the caller
+	void _plan_hidden_mines();
+	Cell_Count _sweep_zeros(const size_t start_index);
+	// Calls f with the compile-time shape of a preset board, or the runtime shape of a custom one
+	template<typename F>
+	decltype(auto) _visit_board(F&& f) const {
+		switch (__diff) {
+		case Difficulty::Easy: return f(Fixed_board<s_Preset_Grid_sizes[0].x, s_Preset_Grid_sizes[0].y>{});
+		case Difficulty::Medium: return f(Fixed_board<s_Preset_Grid_sizes[1].x, s_Preset_Grid_sizes[1].y>{});
+		case Difficulty::Hard: return f(Fixed_board<s_Preset_Grid_sizes[2].x, s_Preset_Grid_sizes[2].y>{});
+		case Difficulty::Expert: return f(Fixed_board<s_Preset_Grid_sizes[3].x, s_Preset_Grid_sizes[3].y>{});
+		default: return f(Dynamic_board{ __width, __height, &__neighborhood });
+		}
+	}
+
+	void _adjust_adjacent_counts(const size_t index, const int delta);
+	bool _keeps_mine_list() const { return (size_t)__bombs_count * 64 < __grid.size(); }
+	void _refresh_mine_list();
+	// Calls f(index) for every mine, from the list if it is valid, by scanning the board otherwise
+	template<typename F>
+	void _for_each_mine_index(F&& f) const {
+		if (__is_mine_list_valid) {
+			for (const size_t index : __mine_indices)
+				f(index);
+			return;
+		}
+		if (!is_mapped()) {
+			__mines.for_each_set([&](const Cell_Value row, const Cell_Value col) { f((size_t)row * __width + col); });
+			return;
+		}
+
+		// Dense mapped boards have neither, or a list not rebuilt yet
+		for (size_t index{}; index < __grid.size(); index++) {
+			if (__grid[index].is_bomb())
+				f(index);
+		}
+	}
+	void _add_mine(const size_t index);
+	void _remove_mine(const size_t index);
+	void _begin_edit();
+	// Bumps the tiles of the cell and its neighbors after a mine was added or removed there
+	void _on_mine_edited(const size_t index);
+
+	Game_counters _counters() const { return { __remaining_bombs, __exploded_bombs, __remaining_cells, __flagged_count, __is_game_over }; }
+	void _set_counters(const Game_counters& counters);
+	Pos _pos(const size_t index) const { return { (Cell_Value)(index % __width), (Cell_Value)(index / __width) }; }
+	void _emit(const Game_event_type type, const Pos cell) { if (__events) __events->push_back({ type, cell }); }
+	// Bumps the version of the cell's tile and tells the listener
+	void _on_cell_changed(const size_t index, const Game_event_type type);
+	void _touch_all_tiles();
+
+	void _begin_move();
+	void _set_cell(const size_t index, const Cell cell) { _set_cell(index, cell, cell_event_type(__grid[index], cell)); }
+	void _set_cell(const size_t index, const Cell cell, const Game_event_type event);
+	void _end_move();
+	// Drops the undo history, the board changed as a whole. is_clean if every cell is unsweeped now
+	void _reset_history(const bool is_clean);
+	// Drops the undo history only, the caller reports the cells it changes
+	void _drop_history(const bool is_clean);
 };
 
 MineSweeper_NS_End
\ No newline at end of file
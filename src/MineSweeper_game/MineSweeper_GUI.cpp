@@ -1,8 +1,10 @@
 ﻿#include "imgui_wrapper.h"
 #include "MineSweeper.h"
+#include "MS_Worker.h"
 #include "MS_Utilities.h"
 
 #include <thread>
+#include <random>
 #include <map>
 #include <functional>
 #include <filesystem>
@@ -52,6 +54,8 @@ struct GameStatus {
 	bool FitGridToScreen = true;
 	bool CloseCurrentGame = false;
 	bool GameEnded = false;
+	// Moves are played on the engine worker thread while a game is on, the grid is drawn from its snapshots
+	bool UseEngineWorker = true;
 
 	MiSw Pos LastMineExploded{};
 
@@ -177,12 +181,12 @@ void GamePlaySound(const GameSounds sound) {
 
 void DrawCellContent(const minesweeper::Cell& cell, const ImVec2 cellMin, const ImVec2 cellMax, const int cellSize, ImDrawList* drawList) {
 	// Draw content
-	if (cell.is_sweeped() && !cell.is_bomb() && cell.value > 0) {
+	if (cell.is_sweeped() && !cell.is_bomb() && cell.value() > 0) {
 		char buf[2];
-		snprintf(buf, 2, "%d", cell.value);
+		snprintf(buf, 2, "%d", cell.value());
 
 		ImU32 numberColor;
-		switch (cell.value) {
+		switch (cell.value()) {
 		case 1: numberColor = IM_COL32(0, 0, 255, 255); break;        // Blue
 		case 2: numberColor = IM_COL32(0, 128, 0, 255); break;        // Green
 		case 3: numberColor = IM_COL32(255, 0, 0, 255); break;        // Red
@@ -420,7 +424,47 @@ void DrawCellBackground2(const minesweeper::Cell& cell, const minesweeper::Pos p
 	drawList->AddRect(scaledMin, scaledMax, borderColor, rounding, 0, borderThickness);
 }
 
-void HandleGridClick(minesweeper::MineSweeper& game, const minesweeper::Cell_Value row, const minesweeper::Cell_Value col, bool is_hovered) {
+// Board the grid is drawn from, published by the engine worker while it runs, by the UI thread otherwise
+static minesweeper::Snapshot_buffer s_Snapshots;
+static minesweeper::Game_worker s_Worker;
+
+static void PlayActionSounds(const minesweeper::Action_result& result) {
+	if (result.Outcome == minesweeper::Action_outcome::Mine_hit) {
+		GamePlaySound(GameSounds::Explosion);
+		s_Status.LastMineExploded = result.ExplodedCell;
+	}
+	else if (result.Outcome == minesweeper::Action_outcome::Changed) {
+		GamePlaySound((result.Type == minesweeper::Action_type::Toggle_mark) ? GameSounds::FlagCell : GameSounds::RevealCell);
+	}
+}
+
+// Actions the worker's queue had no room for, submitted again on the next frames in click order
+static std::vector<minesweeper::Action> s_PendingActions;
+
+static void SubmitPendingActions() {
+	size_t submitted{};
+	while (submitted < s_PendingActions.size() && s_Worker.submit(s_PendingActions[submitted]))
+		submitted++;
+
+	s_PendingActions.erase(s_PendingActions.begin(), s_PendingActions.begin() + submitted);
+}
+
+// Sounds come with the result, right away without a worker, a few frames later with it
+static void RunAction(minesweeper::MineSweeper& game, const minesweeper::Action& action) {
+	if (!s_Worker.is_running())
+		PlayActionSounds(minesweeper::run_action(game, action));
+	else if (!s_PendingActions.empty() || !s_Worker.submit(action))
+		s_PendingActions.push_back(action);
+}
+
+static const minesweeper::Board_snapshot& AcquireBoard(const minesweeper::MineSweeper& game) {
+	if (!s_Worker.is_running())
+		s_Snapshots.publish(game);
+
+	return s_Snapshots.acquire();
+}
+
+void HandleGridClick(minesweeper::MineSweeper& game, const minesweeper::Cell& cell, const minesweeper::Cell_Value row, const minesweeper::Cell_Value col, bool is_hovered) {
 
 	if (ImGui::IsKeyPressed(ImGuiKey_F)) {
 		// F key was pressed
@@ -433,12 +477,9 @@ void HandleGridClick(minesweeper::MineSweeper& game, const minesweeper::Cell_Val
 	bool leftClick = ImGui::IsMouseClicked(ImGuiMouseButton_Left);
 	bool rightClick = ImGui::IsMouseClicked(ImGuiMouseButton_Right);
 
-	const auto& cell = game.get_cell(row, col);
-
-	// Handle click
 	if (is_hovered) {
 		if (leftClick && !cell.is_sweeped() && !cell.is_marked()) {
-			game.sweep(row, col);
+			RunAction(game, { minesweeper::Action_type::Sweep, { col, row } });
 
 			s_flipStatesMap[{row, col}] = { true, ImGui::GetTime() };
 			s_bounceMap[{row, col}] = { true, ImGui::GetTime() };
@@ -449,19 +490,12 @@ void HandleGridClick(minesweeper::MineSweeper& game, const minesweeper::Cell_Val
 
 				s_Status.FirstRun = false;
 			}
-
-			if (game.is_bomb(row, col)) {
-				GamePlaySound(GameSounds::Explosion);
-				s_Status.LastMineExploded.x = col;
-				s_Status.LastMineExploded.y = row;
-			}
-
-			else
-				GamePlaySound(GameSounds::RevealCell);
-
+		}
+		else if (leftClick && cell.is_sweeped() && !cell.is_bomb()) {
+			RunAction(game, { minesweeper::Action_type::Chord, { col, row } });
 		}
 		else if (rightClick && !cell.is_sweeped()) {
-			game.toggle_mark(row, col);
+			RunAction(game, { minesweeper::Action_type::Toggle_mark, { col, row } });
 
 			if (s_Status.FirstRun) {
 				game.init_timer(ImGui::GetTime());
@@ -469,8 +503,6 @@ void HandleGridClick(minesweeper::MineSweeper& game, const minesweeper::Cell_Val
 
 				s_Status.FirstRun = false;
 			}
-
-			GamePlaySound(GameSounds::FlagCell);
 		}
 	}// is_hovered
 }
@@ -512,7 +544,7 @@ void UpperRibbon(minesweeper::MineSweeper& game, bool& p_open) {
 	}
 }
 
-void InformationRibbon(minesweeper::MineSweeper& game) {
+void InformationRibbon(minesweeper::MineSweeper& game, const minesweeper::Board_snapshot& board) {
 
 	ImGui::PushStyleColor(ImGuiCol_ChildBg, IM_COL32(25, 25, 35, 240));
 
@@ -525,7 +557,7 @@ void InformationRibbon(minesweeper::MineSweeper& game) {
 		ImVec2 emojiSize(min(avail_region.x, avail_region.y) * 0.7f, min(avail_region.x, avail_region.y) * 0.7f);
 		ImVec2 emojiPos = ImVec2((avail_region.x - emojiSize.x) * 0.5f, ImGui::GetCursorPosY());
 		ImGui::SetCursorPos(emojiPos);
-		if (game.is_game_over())
+		if (board.is_game_over())
 			ImGui::Image(s_Images.EmojiSad.ImGuiTexID, emojiSize);
 		else
 			ImGui::Image(s_Images.EmojiHappy.ImGuiTexID, emojiSize);
@@ -541,7 +573,7 @@ void InformationRibbon(minesweeper::MineSweeper& game) {
 		ImGui::SetCursorPos(bombIconPos);
 		ImGui::Image(s_Images.Mine.ImGuiTexID, iconSize);
 		ImGui::SameLine();
-		ImGui::Text("%d/%d", game.get_remaining_bombs(), game.get_mine_count());
+		ImGui::Text("%lld/%lld", (long long)board.get_remaining_bombs(), (long long)board.get_mine_count());
 
 		// === Timer ===
 		ImVec2 clockIconPos = ImVec2((ImGui::GetContentRegionAvail().x - iconSize.x - 60) * 0.5f, ImGui::GetCursorPosY() + 10);
@@ -639,15 +671,15 @@ bool IsCellHovered(const ImVec2 cellMin, const ImVec2 cellMax) {
 	return hovered;
 }
 
-void DrawMinesweeperGrid(minesweeper::MineSweeper& game) {
+void DrawMinesweeperGrid(minesweeper::MineSweeper& game, const minesweeper::Board_snapshot& board) {
 
 	static float zoom = 1.0f;
 	static ImVec2 panOffset = ImVec2(0.0f, 0.0f);
 	static ImVec2 originFitOffset = ImVec2(0.0f, 0.0f);
 	static float cellFitFactor = 1.f;
 
-	int width = game.width();
-	int height = game.height();
+	int width = board.width();
+	int height = board.height();
 	ImGui::PushStyleColor(ImGuiCol_ChildBg, IM_COL32(15, 15, 25, 255)); // very dark blue-gray
 
 	auto grid_region_size = ImVec2((s_Status.SidebarVisible) ? ImGui::GetContentRegionAvail().x * 0.8f : 0, 0);
@@ -684,8 +716,9 @@ void DrawMinesweeperGrid(minesweeper::MineSweeper& game) {
 		ImDrawList* drawList = ImGui::GetWindowDrawList();
 
 		for (int r = 0; r < height; ++r) {
+			const auto row = board.get_row<minesweeper::HOT_PATH_ACCESS>(r);
 			for (int c = 0; c < width; ++c) {
-				const auto& cell = game.get_cell(r, c);
+				const auto& cell = row[c];
 
 				ImVec2 cellMin = {
 					origin.x + c * (cellSize + padding),
@@ -699,7 +732,7 @@ void DrawMinesweeperGrid(minesweeper::MineSweeper& game) {
 				// Check for hover
 				bool hovered = IsCellHovered(cellMin, cellMax);
 
-				HandleGridClick(game, r, c, hovered);
+				HandleGridClick(game, cell, r, c, hovered);
 
 				// Draw cell background
 				DrawCellBackground2(cell, { r,c }, cellMin, cellMax, hovered, drawList);
@@ -759,7 +792,7 @@ void GameWonPopupModal(minesweeper::MineSweeper& game) {
 			else
 				ImGui::Text("Best Time: N/A");
 			ImGui::Text("Time: %d:%02d", (int)game.get_time() / 60, (int)game.get_time() % 60);
-			ImGui::Text("Mistakes: %d", game.get_exploded_mines());
+			ImGui::Text("Mistakes: %lld", (long long)game.get_exploded_mines());
 		}
 		ImGui::EndChild();
 		//ImGui::Separator();
@@ -861,7 +894,7 @@ void SecondChancePopupModal(minesweeper::MineSweeper& game) {
 		}
 		ImGui::SameLine();
 		if (ImGui::Button("Roll a dice!")) {
-			if (rand() % 2) {
+			if (std::random_device{}() % 2) {
 				game.revive_game();
 				game.start_timer();
 
@@ -938,45 +971,6 @@ void ShowPopups(minesweeper::MineSweeper& game) {
 	}
 }
 
-void RevealMinesInStyle(minesweeper::MineSweeper& game, sc::milliseconds total_anim_time) {
-	auto center_row = s_Status.LastMineExploded.y;
-	auto center_col = s_Status.LastMineExploded.x;
-
-	int wave_index = 1;
-	const auto max_index = max(game.height(), game.width());
-	while (wave_index < max_index) {
-
-		for (int i{}; i < 2 * wave_index + 1; i++) {
-
-			if (center_row - wave_index + i < 0 || center_row - wave_index + i >= game.height())
-				continue;
-
-			for (int j{}; j < 2 * wave_index + 1; j++) {
-
-				if (i != 0 && i != 2 * wave_index) {
-					if (j > 0) {
-						j = 2 * wave_index;
-					}
-				}
-
-				if (center_col - wave_index + j < 0 || center_col - wave_index + j >= game.width())
-					continue;
-
-				auto& cell = game.get_cell(center_row - wave_index + i, center_col - wave_index + j);
-				if (!cell.is_marked() && cell.is_bomb()) {
-					cell.state = minesweeper::Cell_State::Sweeped;
-					GamePlaySound(GameSounds::Explosion);
-				}
-
-			}
-		}
-
-		wave_index++;
-
-		std::this_thread::sleep_for(total_anim_time / (max_index + 1));
-	}
-}
-
 void HandleGameEnd(minesweeper::MineSweeper& game) {
 	static constexpr double game_won_anim_duration = 3.f;
 	if (s_Animations.GameWon.active) {
@@ -1008,13 +1002,13 @@ void HandleGameEnd(minesweeper::MineSweeper& game) {
 
 		if (!animation_running) {
 			animation_running = true;
-
-			if (s_thr.joinable()) {
-				s_thr.join(); // Ensure the previous thread is joined
-			}
-			s_thr = std::thread(RevealMinesInStyle, std::ref(game), sc::milliseconds((size_t)reveal_mines_anim_duration * 1000));
+			// Mines explode ring by ring around the one the player hit
+			game.start_mine_reveal(s_Animations.RevealMines.startTime, reveal_mines_anim_duration, s_Status.LastMineExploded);
 		}
 
+		if (game.advance_mine_reveal(ImGui::GetTime()))
+			GamePlaySound(GameSounds::Explosion);
+
 
 		if (time > reveal_mines_anim_duration) {
 			s_Animations.RevealMines.active = false;
@@ -1025,7 +1019,20 @@ void HandleGameEnd(minesweeper::MineSweeper& game) {
 	}
 }
 
-void HandleGameState(minesweeper::MineSweeper& game, bool& p_open) {
+void HandleGameState(minesweeper::MineSweeper& game, const minesweeper::Board_snapshot& board, bool& p_open) {
+	// Whole board changes and the end of the game are handled here, the game comes back from the worker first
+	if (s_Status.RestartGame || s_Status.NewGame || s_Status.CloseCurrentGame || (!s_Status.GameEnded && (board.is_game_over() || board.is_game_won()))) {
+		s_Worker.stop();
+
+		// The move that ended the game may have finished after the results were polled this frame
+		minesweeper::Action_result result{};
+		while (s_Worker.poll(result))
+			PlayActionSounds(result);
+
+		// Clicks still waiting were made on a board that is now replaced or over
+		s_PendingActions.clear();
+	}
+
 	if (s_Status.RestartGame) {
 		game.restart_game();
 		s_Status.restart();
@@ -1047,7 +1054,7 @@ void HandleGameState(minesweeper::MineSweeper& game, bool& p_open) {
 	}
 
 	// Using g_LockInputs to prevent calling this function every frame
-	if (!s_Status.GameEnded && (game.is_game_over())) {
+	if (!s_Status.GameEnded && (board.is_game_over())) {
 		s_Status.GameEnded = true;
 		s_Status.LockInputs = true;
 
@@ -1058,7 +1065,7 @@ void HandleGameState(minesweeper::MineSweeper& game, bool& p_open) {
 		s_Animations.GameOver.startTime = ImGui::GetTime();
 
 	}
-	else if (!s_Status.GameEnded && game.is_game_won()) {
+	else if (!s_Status.GameEnded && board.is_game_won()) {
 		s_Status.GameEnded = true;
 		s_Status.LockInputs = true;
 
@@ -1096,15 +1103,25 @@ void MainGamePage(minesweeper::MineSweeper& game, bool& p_open) {
 	ImGui::SetNextWindowSize(viewport->WorkSize);
 
 	if (ImGui::Begin("Minesweeper_MainPage", nullptr, window_flags)) {
+		if (s_Status.UseEngineWorker && !s_Status.GameEnded && !s_Worker.is_running())
+			s_Worker.start(game, s_Snapshots);
+
+		minesweeper::Action_result result{};
+		while (s_Worker.poll(result))
+			PlayActionSounds(result);
+		SubmitPendingActions();
+
+		const auto& board = AcquireBoard(game);
+
 		UpperRibbon(game, p_open);
 
-		DrawMinesweeperGrid(game);
+		DrawMinesweeperGrid(game, board);
 
 		ImGui::SameLine();
 		if (s_Status.SidebarVisible)
-			InformationRibbon(game);
+			InformationRibbon(game, board);
 
-		HandleGameState(game, p_open);
+		HandleGameState(game, board, p_open);
 	}
 	ImGui::End();
 }
@@ -1257,7 +1274,7 @@ void CustomGameConfigPage(minesweeper::MineSweeper& game, bool &p_open) {
 
 	static int height{ game.height() };
 	static int width{ game.width() };
-	static int mines{ game.get_mine_count() };
+	static int mines{ (int)game.get_mine_count() };
 
 	static ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoSavedSettings
 		/*| ImGuiWindowFlags_MenuBar*/;
@@ -1284,7 +1301,7 @@ void CustomGameConfigPage(minesweeper::MineSweeper& game, bool &p_open) {
 		ImGui::SameLine();
 		ImGui::Text("Classic | %s %dx%d", game.get_diff_str(), game.height(), game.width());
 
-		DrawMinesweeperGrid(game);
+		DrawMinesweeperGrid(game, AcquireBoard(game));
 
 		ImGui::SameLine();
 		ImGui::PushStyleColor(ImGuiCol_ChildBg, IM_COL32(25, 25, 35, 240));
@@ -1308,32 +1325,27 @@ void CustomGameConfigPage(minesweeper::MineSweeper& game, bool &p_open) {
 			//ImGui::PushFont(g_Fonts[XLarg]);
 
 			// === Height ===
-			if (ImGui::SliderInt("Height", &height, 9, 40)) {
-				game.new_game(height, width, mines);
-				game.randomly_flag_mine_count();
+			const bool height_changed = ImGui::SliderInt("Height", &height, 9, 40);
 
+			// === Width ===
+			const bool width_changed = ImGui::SliderInt("Width", &width, 9, 40);
+
+			// The preview board is resized in place, it never grows past 40x40 so no frame allocates
+			if (height_changed || width_changed) {
 				if (mines > (height * width) * MAX_MINE_RATIO)
 					mines = (height * width) * MAX_MINE_RATIO;
 				else if (mines < (height * width) * MIN_MINE_RATIO) {
 					mines = (height * width) * MIN_MINE_RATIO;
 				}
-			}
 
-			// === Width ===
-			if (ImGui::SliderInt("Width", &width, 9, 40)) {
 				game.new_game(height, width, mines);
 				game.randomly_flag_mine_count();
-
-				if (mines > (height * width) * MAX_MINE_RATIO)
-					mines = (height * width) * MAX_MINE_RATIO;
-				else if (mines < (height * width) * MIN_MINE_RATIO) {
-					mines = (height * width) * MIN_MINE_RATIO;
-				}
 			}
 
 			// === Bombs ===
-			if (ImGui::SliderInt("Mines", &mines, (height * width) * 0.15f, (height * width) * MAX_MINE_RATIO)) {
-				game.new_game(height, width, mines);
+			// Only the difference in flags is added or removed
+			if (ImGui::SliderInt("Mines", &mines, (height * width) * MIN_MINE_RATIO, (height * width) * MAX_MINE_RATIO)) {
+				game.set_mine_count(mines);
 				game.randomly_flag_mine_count();
 			}
 
@@ -1685,6 +1697,7 @@ bool imgui_wrapper::USER_startup() {
 }
 
 void imgui_wrapper::USER_cleanup() {
+	s_Worker.stop();
 	s_Images.release();
 
 	if (s_thr.joinable())